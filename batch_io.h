@@ -0,0 +1,638 @@
+#ifndef BATCH_IO_H
+#define BATCH_IO_H
+/* batch_io.h
+    Whole-file reads for many files at once, used when project_lexer.exe
+    or project_parser.exe get more than one file on the command line.
+    bio_open() takes the list of paths.  bio_next() hands the files back
+    in list order, each in the buffer of one slot of a fixed pool, and
+    bio_release() gives the slot back so the next file can be read into
+    it.  Up to BIO_WINDOW files are being opened and read at a time:
+      - Linux 5.11 and later: io_uring, driven through the raw system
+        calls (no liburing); opens, reads and closes are queued and go
+        to the kernel in one io_uring_enter per round, which waits at
+        most BIO_WAIT_MS for a completion
+      - elsewhere, or when the kernel refuses io_uring (too old, or
+        blocked by seccomp): BIO_THREADS threads doing open/read/close;
+        they and bio_next sleep on a condition variable while they wait
+    If io_uring_enter fails part way through, the loader waits for what
+    the kernel already holds, closes the files it opened and goes on
+    with the thread pool from the file bio_next is waiting for.
+    bio_close gives reads still out BIO_DRAIN_SECONDS, then cancels them
+    and gives them as long again.
+    Slot buffers start at BIO_BUF bytes, grow for larger files and keep
+    their size, so a long run stops allocating.  Each buffer has one
+    spare byte after the file for the line reader's NUL (text_input.h).
+    The buffers are plain malloc: worker threads grow them, so
+    --mem-profile sees them only in peak RSS.
+    syscall and pread are GNU/XSI declarations: a file that includes this
+    defines _GNU_SOURCE before its first #include.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "thread_compat.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#define BIO_HAVE_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#ifndef _GNU_SOURCE
+#error "define _GNU_SOURCE before the first #include (batch_io.h)"
+#endif
+#ifndef AT_FDCWD
+#define AT_FDCWD -100
+#endif
+#endif
+
+#define BIO_WINDOW 32               /* files in flight, and pool slots */
+#define BIO_BUF (64 * 1024)         /* first size of a slot buffer */
+#define BIO_THREADS 8               /* thread pool backend */
+#define BIO_DRAIN_SECONDS 2.0       /* wait for reads still out this long, at close or after a failure */
+#define BIO_WAIT_MS 100             /* longest single wait in io_uring_enter */
+
+enum { BIO_AUTO, BIO_THREAD_POOL, BIO_URING };
+
+typedef struct {
+    const char *path;
+    int index;                      /* position in the path list */
+    char *data;
+    size_t len;
+    int err;                        /* errno value, 0 when the file was read */
+} bio_file;
+
+typedef struct {
+    bio_file file;
+    size_t cap;
+    volatile long ready;            /* thread pool: the file is complete */
+    cond_t wake;                    /* thread pool: ready set, or the slot released */
+    int fd;                         /* io_uring: open, no close queued yet (-1: none) */
+    int reading;                    /* io_uring: a read into data is queued */
+    int done;                       /* io_uring: the file is complete */
+} bio_slot;
+
+#ifdef BIO_HAVE_URING
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_map_len, cq_map_len, sqes_len;
+    unsigned to_submit;             /* queued, not yet passed to the kernel */
+    int inflight;                   /* queued, completion not seen yet */
+    int failed;                     /* io_uring_enter failed: nothing more goes in */
+} bio_uring;
+#endif
+
+typedef struct {
+    const char *const *paths;
+    int npaths;
+    int backend;
+    bio_slot slot[BIO_WINDOW];
+    int next_out;                   /* next file bio_next returns */
+    volatile long released;         /* file k may start once k < released + BIO_WINDOW */
+    volatile long stop;             /* bio_close before the end of the list */
+    /* thread pool: lock guards released, stop and the slots' ready flags
+       for the waits on their wake */
+    mutex_t lock;
+    volatile long next_in;
+    thread_t threads[BIO_THREADS];
+    int nthreads;
+#ifdef BIO_HAVE_URING
+    bio_uring ring;
+    int queued;                     /* files whose open has been queued */
+#endif
+} bio_loader;
+
+/* Makes room for at least one more byte plus the spare one. */
+static inline int bio_grow(bio_slot *s)
+{
+    size_t ncap = s->cap ? s->cap * 2 : BIO_BUF;
+    char *p = (char *)realloc(s->file.data, ncap);
+    if (!p) return ENOMEM;
+    s->file.data = p;
+    s->cap = ncap;
+    return 0;
+}
+
+/* ---- thread pool backend ---- */
+
+static inline void bio_read_whole(bio_slot *s)
+{
+    long n;
+    int fd;
+
+    s->file.len = 0;
+    s->file.err = 0;
+#ifdef _WIN32
+    fd = _open(s->file.path, _O_RDONLY | _O_BINARY);
+#else
+    fd = open(s->file.path, O_RDONLY);
+#endif
+    if (fd < 0) {
+        s->file.err = errno;
+        return;
+    }
+    for (;;) {
+        size_t want;
+        if (s->file.len + 1 >= s->cap && (s->file.err = bio_grow(s)) != 0) break;
+        want = s->cap - 1 - s->file.len;
+#ifdef _WIN32
+        n = _read(fd, s->file.data + s->file.len, (unsigned)want);
+#else
+        n = (long)pread(fd, s->file.data + s->file.len, want, (off_t)s->file.len);
+#endif
+        if (n < 0) {
+            s->file.err = errno;
+            break;
+        }
+        s->file.len += (size_t)n;
+        /* a short read of a regular file is its end */
+        if ((size_t)n < want) break;
+    }
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+static inline THREAD_RET THREAD_CALL bio_worker(void *arg)
+{
+    bio_loader *ld = (bio_loader *)arg;
+    bio_slot *s;
+    long k, stop;
+
+    for (;;) {
+        k = atomic_add(&ld->next_in, 1) - 1;
+        if (k >= ld->npaths) break;
+        /* wait for the slot of file k - BIO_WINDOW to be released */
+        mutex_lock(&ld->lock);
+        s = &ld->slot[k % BIO_WINDOW];
+        while (k >= ld->released + BIO_WINDOW && !ld->stop) cond_wait(&s->wake, &ld->lock);
+        stop = ld->stop;
+        mutex_unlock(&ld->lock);
+        if (stop) break;
+        s->file.path = ld->paths[k];
+        s->file.index = (int)k;
+        bio_read_whole(s);
+        mutex_lock(&ld->lock);
+        s->ready = 1;
+        cond_wake_all(&s->wake);
+        mutex_unlock(&ld->lock);
+    }
+    return THREAD_RESULT;
+}
+
+static inline void bio_start_threads(bio_loader *ld)
+{
+    int i;
+
+    ld->backend = BIO_THREAD_POOL;
+    for (i = 0; i < BIO_THREADS && i < ld->npaths - ld->next_out; i++) {
+        if (thread_start(&ld->threads[i], bio_worker, ld) != 0) break;
+        ld->nthreads++;
+    }
+    /* no threads at all: the reads happen in bio_next */
+}
+
+/* ---- io_uring backend ---- */
+
+#ifdef BIO_HAVE_URING
+enum { BIO_OP_OPEN, BIO_OP_READ, BIO_OP_CLOSE, BIO_OP_CANCEL };
+
+static inline int bio_uring_init(bio_uring *r, unsigned entries)
+{
+    struct io_uring_params p;
+    struct io_uring_probe *probe;
+    size_t probe_len = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+    int ok;
+
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) return -1;
+
+    /* the opcodes used here arrived in Linux 5.6 */
+    probe = (struct io_uring_probe *)calloc(1, probe_len);
+    ok = probe && syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PROBE, probe, 256) >= 0 &&
+         probe->last_op >= IORING_OP_READ &&
+         (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+         (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+         (probe->ops[IORING_OP_CLOSE].flags & IO_URING_OP_SUPPORTED) &&
+         (probe->ops[IORING_OP_ASYNC_CANCEL].flags & IO_URING_OP_SUPPORTED) &&
+         (p.features & IORING_FEAT_EXT_ARG);        /* timed waits, Linux 5.11 */
+    free(probe);
+    if (!ok) {
+        close(r->fd);
+        return -1;
+    }
+
+    r->entries = p.sq_entries;
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+        r->cq_map_len = r->sq_map_len;
+    }
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_map == MAP_FAILED) {
+        close(r->fd);
+        return -1;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_map = r->sq_map;
+    } else {
+        r->cq_map = mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_CQ_RING);
+        if (r->cq_map == MAP_FAILED) {
+            munmap(r->sq_map, r->sq_map_len);
+            close(r->fd);
+            return -1;
+        }
+    }
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe *)mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        if (r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+        munmap(r->sq_map, r->sq_map_len);
+        close(r->fd);
+        return -1;
+    }
+    r->sq_head = (unsigned *)((char *)r->sq_map + p.sq_off.head);
+    r->sq_tail = (unsigned *)((char *)r->sq_map + p.sq_off.tail);
+    r->sq_mask = (unsigned *)((char *)r->sq_map + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)((char *)r->sq_map + p.sq_off.array);
+    r->cq_head = (unsigned *)((char *)r->cq_map + p.cq_off.head);
+    r->cq_tail = (unsigned *)((char *)r->cq_map + p.cq_off.tail);
+    r->cq_mask = (unsigned *)((char *)r->cq_map + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)((char *)r->cq_map + p.cq_off.cqes);
+    return 0;
+}
+
+static inline void bio_uring_free(bio_uring *r)
+{
+    munmap(r->sqes, r->sqes_len);
+    if (r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    munmap(r->sq_map, r->sq_map_len);
+    close(r->fd);
+}
+
+/* Passes queued entries to the kernel and, with wait, waits up to
+   BIO_WAIT_MS for a completion; running out of time is not a failure. */
+static inline int bio_uring_enter(bio_uring *r, int wait)
+{
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    long n;
+
+    memset(&arg, 0, sizeof(arg));
+    ts.tv_sec = 0;
+    ts.tv_nsec = BIO_WAIT_MS * 1000000LL;
+    arg.ts = (unsigned long long)(size_t)&ts;
+    do {
+        if (wait)
+            n = syscall(__NR_io_uring_enter, r->fd, r->to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &arg, sizeof(arg));
+        else
+            n = syscall(__NR_io_uring_enter, r->fd, r->to_submit, 0, 0, NULL, 0);
+    } while (n < 0 && errno == EINTR);
+    /* the kernel only reports the timeout when it took no entries */
+    if (n < 0 && errno == ETIME) n = 0;
+    if (n < 0) {
+        r->failed = 1;
+        return -1;
+    }
+    r->to_submit -= (unsigned)n;
+    return 0;
+}
+
+/* Next free submission entry, or NULL once the ring has failed. */
+static inline struct io_uring_sqe *bio_uring_sqe(bio_uring *r)
+{
+    unsigned tail = *r->sq_tail, idx;
+    struct io_uring_sqe *sqe;
+
+    if (r->failed) return NULL;
+    /* every entry is queued and not yet consumed: hand them over first */
+    if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) == r->entries) {
+        if (bio_uring_enter(r, 0) != 0) return NULL;
+        /* the kernel took none of them: it will not take more on retry */
+        if (tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) == r->entries) {
+            r->failed = 1;
+            return NULL;
+        }
+    }
+    idx = tail & *r->sq_mask;
+    sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    return sqe;
+}
+
+static inline void bio_uring_push(bio_uring *r)
+{
+    __atomic_store_n(r->sq_tail, *r->sq_tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+    r->inflight++;
+}
+
+static inline void bio_queue_open(bio_loader *ld, int k)
+{
+    bio_slot *s = &ld->slot[k % BIO_WINDOW];
+    struct io_uring_sqe *sqe = bio_uring_sqe(&ld->ring);
+
+    s->file.path = ld->paths[k];
+    s->file.index = k;
+    s->file.len = 0;
+    s->file.err = 0;
+    s->fd = -1;
+    s->reading = 0;
+    s->done = 0;
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (unsigned long long)(size_t)s->file.path;
+    sqe->open_flags = O_RDONLY;
+    sqe->user_data = (unsigned long long)(k % BIO_WINDOW) << 2 | BIO_OP_OPEN;
+    bio_uring_push(&ld->ring);
+}
+
+static inline void bio_queue_read(bio_loader *ld, bio_slot *s)
+{
+    struct io_uring_sqe *sqe;
+
+    if (s->file.len + 1 >= s->cap && (s->file.err = bio_grow(s)) != 0) return;
+    sqe = bio_uring_sqe(&ld->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = s->fd;
+    sqe->addr = (unsigned long long)(size_t)(s->file.data + s->file.len);
+    sqe->len = (unsigned)(s->cap - 1 - s->file.len);
+    sqe->off = s->file.len;
+    sqe->user_data = (unsigned long long)(s - ld->slot) << 2 | BIO_OP_READ;
+    bio_uring_push(&ld->ring);
+    s->reading = 1;
+}
+
+/* Asks the kernel to drop the read queued into s. */
+static inline void bio_queue_cancel(bio_loader *ld, bio_slot *s)
+{
+    struct io_uring_sqe *sqe = bio_uring_sqe(&ld->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = (unsigned long long)(s - ld->slot) << 2 | BIO_OP_READ;
+    sqe->user_data = BIO_OP_CANCEL;
+    bio_uring_push(&ld->ring);
+}
+
+/* A failed ring leaves s->fd set, and bio_uring_drain closes it. */
+static inline void bio_queue_close(bio_loader *ld, bio_slot *s)
+{
+    struct io_uring_sqe *sqe = bio_uring_sqe(&ld->ring);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = s->fd;
+    sqe->user_data = BIO_OP_CLOSE;
+    bio_uring_push(&ld->ring);
+    s->fd = -1;
+}
+
+static inline void bio_complete(bio_loader *ld, unsigned long long tag, int res)
+{
+    bio_slot *s = &ld->slot[tag >> 2];
+    size_t want;
+
+    if (ld->ring.failed) {
+        /* draining: nothing more is queued, so close here what the ring opened */
+        if ((tag & 3) == BIO_OP_OPEN && res >= 0) close(res);
+        if ((tag & 3) == BIO_OP_READ) s->reading = 0;
+        return;
+    }
+    switch ((int)(tag & 3)) {
+    case BIO_OP_OPEN:
+        if (res < 0) {
+            s->file.err = -res;
+            s->done = 1;
+        } else {
+            s->fd = res;
+            if (ld->stop) {
+                bio_queue_close(ld, s);
+                s->done = 1;
+                break;
+            }
+            bio_queue_read(ld, s);
+            if (s->file.err) {
+                bio_queue_close(ld, s);
+                s->done = 1;
+            }
+        }
+        break;
+    case BIO_OP_READ:
+        s->reading = 0;
+        want = s->cap - 1 - s->file.len;
+        if (res < 0) {
+            s->file.err = -res;
+        } else {
+            s->file.len += (size_t)res;
+            /* a full read may not be the end of the file: read on */
+            if ((size_t)res == want && !ld->stop) {
+                bio_queue_read(ld, s);
+                if (!s->file.err) break;
+            }
+        }
+        bio_queue_close(ld, s);
+        s->done = 1;
+        break;
+    }
+}
+
+static inline void bio_reap(bio_loader *ld)
+{
+    bio_uring *r = &ld->ring;
+    unsigned head = *r->cq_head, tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+
+    while (head != tail) {
+        cqe = &r->cqes[head & *r->cq_mask];
+        r->inflight--;
+        bio_complete(ld, cqe->user_data, cqe->res);
+        head++;
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+        tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    }
+}
+
+/* After io_uring_enter failed (or bio_close ran out of time): entries
+   the kernel never took are dropped (their closes done here), and the
+   ones it did take are waited for by watching the completion queue,
+   which it fills without another enter.  Then every file the ring opened
+   is closed and the ring torn down.  A slot whose read is still out
+   after BIO_DRAIN_SECONDS keeps nothing: the kernel may still write into
+   its buffer, and no cancel can be queued on a failed ring, so the
+   buffer is leaked on purpose and the slot starts a new one. */
+static inline void bio_uring_drain(bio_loader *ld)
+{
+    bio_uring *r = &ld->ring;
+    unsigned head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    struct io_uring_sqe *sqe;
+    double t0 = wall_seconds();
+    int i;
+
+    r->failed = 1;
+    for (; head != *r->sq_tail; head++) {
+        sqe = &r->sqes[r->sq_array[head & *r->sq_mask]];
+        if ((sqe->user_data & 3) == BIO_OP_READ) ld->slot[sqe->user_data >> 2].reading = 0;
+        if ((sqe->user_data & 3) == BIO_OP_CLOSE) close(sqe->fd);
+        r->inflight--;
+    }
+    r->to_submit = 0;
+    for (;;) {
+        bio_reap(ld);
+        if (r->inflight == 0 || wall_seconds() - t0 > BIO_DRAIN_SECONDS) break;
+        sleep_ms(1);
+    }
+    for (i = 0; i < BIO_WINDOW; i++) {
+        bio_slot *s = &ld->slot[i];
+        if (s->fd >= 0) close(s->fd);
+        s->fd = -1;
+        if (s->reading) {
+            s->file.data = NULL;
+            s->cap = 0;
+            s->reading = 0;
+        }
+    }
+    bio_uring_free(r);
+}
+
+/* The ring failed before file ld->next_out was complete: read it and
+   the rest of the list with the thread pool instead. */
+static inline void bio_uring_fallback(bio_loader *ld)
+{
+    int i;
+
+    bio_uring_drain(ld);
+    for (i = 0; i < BIO_WINDOW; i++) {
+        ld->slot[i].done = 0;
+        ld->slot[i].ready = 0;
+    }
+    ld->next_in = ld->next_out;
+    bio_start_threads(ld);
+}
+#endif
+
+/* ---- common ---- */
+
+/* backend is BIO_AUTO or the one to use; ld->backend says which it got. */
+static inline void bio_open(bio_loader *ld, const char *const *paths, int npaths, int backend)
+{
+    int i;
+
+    memset(ld, 0, sizeof(*ld));
+    ld->paths = paths;
+    ld->npaths = npaths;
+    for (i = 0; i < BIO_WINDOW; i++) ld->slot[i].fd = -1;
+    mutex_init(&ld->lock);
+    for (i = 0; i < BIO_WINDOW; i++) cond_init(&ld->slot[i].wake);
+#ifdef BIO_HAVE_URING
+    if (backend != BIO_THREAD_POOL && bio_uring_init(&ld->ring, 2 * BIO_WINDOW) == 0) {
+        ld->backend = BIO_URING;
+        return;
+    }
+#endif
+    bio_start_threads(ld);
+}
+
+/* Next file in list order, or NULL after the last one. */
+static inline bio_file *bio_next(bio_loader *ld)
+{
+    int k = ld->next_out;
+    bio_slot *s;
+
+    if (k >= ld->npaths) return NULL;
+    s = &ld->slot[k % BIO_WINDOW];
+#ifdef BIO_HAVE_URING
+    if (ld->backend == BIO_URING) {
+        while (!ld->ring.failed && ld->queued < ld->npaths && ld->queued < ld->released + BIO_WINDOW)
+            bio_queue_open(ld, ld->queued++);
+        bio_reap(ld);
+        while (!s->done && !ld->ring.failed) {
+            if (bio_uring_enter(&ld->ring, 1) == 0) bio_reap(ld);
+        }
+        if (s->done) return &s->file;
+        bio_uring_fallback(ld);
+    }
+#endif
+    if (ld->nthreads == 0) {
+        s->file.path = ld->paths[k];
+        s->file.index = k;
+        bio_read_whole(s);
+        return &s->file;
+    }
+    mutex_lock(&ld->lock);
+    while (!s->ready) cond_wait(&s->wake, &ld->lock);
+    mutex_unlock(&ld->lock);
+    return &s->file;
+}
+
+/* Gives the slot of f back; f->data is not valid after this. */
+static inline void bio_release(bio_loader *ld, bio_file *f)
+{
+    bio_slot *s = &ld->slot[f->index % BIO_WINDOW];
+    s->done = 0;
+    ld->next_out++;
+    mutex_lock(&ld->lock);
+    s->ready = 0;
+    ld->released++;
+    cond_wake_all(&s->wake);
+    mutex_unlock(&ld->lock);
+}
+
+static inline void bio_close(bio_loader *ld)
+{
+    int i;
+
+    mutex_lock(&ld->lock);
+    ld->stop = 1;
+    for (i = 0; i < BIO_WINDOW; i++) cond_wake_all(&ld->slot[i].wake);
+    mutex_unlock(&ld->lock);
+#ifdef BIO_HAVE_URING
+    if (ld->backend == BIO_URING) {
+        /* let opens and reads in flight finish, and their closes; reads
+           still out after BIO_DRAIN_SECONDS are cancelled, and given as
+           long again before bio_uring_drain takes over */
+        double t0 = wall_seconds();
+        int cancelled = 0;
+        while (ld->ring.inflight > 0 && !ld->ring.failed) {
+            if (wall_seconds() - t0 > BIO_DRAIN_SECONDS) {
+                if (cancelled) break;
+                for (i = 0; i < BIO_WINDOW; i++)
+                    if (ld->slot[i].reading) bio_queue_cancel(ld, &ld->slot[i]);
+                cancelled = 1;
+                t0 = wall_seconds();
+            }
+            if (bio_uring_enter(&ld->ring, 1) == 0) bio_reap(ld);
+        }
+        if (ld->ring.failed || ld->ring.inflight > 0) bio_uring_drain(ld);
+        else bio_uring_free(&ld->ring);
+    }
+#endif
+    for (i = 0; i < ld->nthreads; i++) thread_join(ld->threads[i]);
+    for (i = 0; i < BIO_WINDOW; i++) free(ld->slot[i].file.data);
+    for (i = 0; i < BIO_WINDOW; i++) cond_free(&ld->slot[i].wake);
+    mutex_free(&ld->lock);
+}
+
+#endif /* BATCH_IO_H */
@@ -0,0 +1,207 @@
+/* bench_batchio.c
+    Benchmark for batch mode file reading (batch_io.h)
+    Writes a directory of small DSL sources (a few KB each, with a large
+    one now and then) and lexes all of them three ways:
+      - one file at a time through stdio, fopen + fgets, as
+        project_lexer.exe reads a single file
+      - batch_io.h with the thread pool backend
+      - batch_io.h with io_uring (Linux only)
+    each with a warm page cache and, where the OS lets a program drop
+    the files from it (posix_fadvise on Linux), a cold one.
+    Usage: bench_batchio.exe [files]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np (memprof.h), syscall and pread (batch_io.h) */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch_io.h"
+#include "lexer_core.h"
+#include "text_input.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(p) _mkdir(p)
+#define remove_dir(p) _rmdir(p)
+#else
+#include <sys/stat.h>
+#define make_dir(p) mkdir(p, 0755)
+#define remove_dir(p) rmdir(p)
+#endif
+
+#define BENCH_DIR "bench_batchio_files"
+#define REPS 3
+
+static void count_token(void *ctx, const char *tok, const char *lex)
+{
+    (void)tok;
+    (void)lex;
+    (*(long *)ctx)++;
+}
+
+static void write_source(const char *path, int n)
+{
+    static const char *body[] = {
+        "    int _val%d = _arg1a + %d..\n",
+        "    printf(\"value: %%d\\n\", _val%d)..\n",
+        "    while (_val%d < %d) {\n        _val1a = _val1a + 1..\n    }\n"
+    };
+    FILE *f = fopen(path, "wb");
+    int i, lines;
+
+    if (!f) {
+        perror("fopen");
+        exit(1);
+    }
+    /* 20 to 200 lines, and every 500th file about 10000 */
+    lines = n % 500 == 499 ? 10000 : 20 + n * 37 % 181;
+    fprintf(f, "#include<stdio.h>\nint file%dFn(int _arg1a) {\n", n);
+    for (i = 0; i < lines; i++) fprintf(f, body[i % 3], i, i);
+    fprintf(f, "    return _arg1a..\n}\nint main() {\n    return 0..\n}\n");
+    fclose(f);
+}
+
+static long lex_reader(ti_reader *tr)
+{
+    lex_state ls;
+    char *line;
+    long tokens = 0;
+    int lineno = 0;
+
+    lex_init(&ls, count_token, &tokens);
+    while ((line = ti_getline(tr, TI_MAXLINE)) != NULL) {
+        line[strcspn(line, "\r\n")] = 0;
+        if (!lex_line(&ls, line, ++lineno)) break;
+    }
+    return tokens;
+}
+
+static long run_stdio(char **paths, int n, long *bytes)
+{
+    char line[TI_MAXLINE];
+    lex_state ls;
+    long tokens = 0;
+    int i, lineno;
+    FILE *f;
+
+    *bytes = 0;
+    for (i = 0; i < n; i++) {
+        f = fopen(paths[i], "rb");
+        if (!f) continue;
+        lineno = 0;
+        lex_init(&ls, count_token, &tokens);
+        while (fgets(line, sizeof(line), f)) {
+            *bytes += (long)strlen(line);
+            line[strcspn(line, "\r\n")] = 0;
+            if (!lex_line(&ls, line, ++lineno)) break;
+        }
+        fclose(f);
+    }
+    return tokens;
+}
+
+static long run_batch(char **paths, int n, int backend, long *bytes)
+{
+    bio_loader ld;
+    bio_file *bf;
+    ti_reader tr;
+    long tokens = 0;
+
+    *bytes = 0;
+    bio_open(&ld, (const char *const *)paths, n, backend);
+    if (ld.backend != backend) {
+        bio_close(&ld);
+        return -1;
+    }
+    while ((bf = bio_next(&ld)) != NULL) {
+        if (!bf->err && ti_open_mem(&tr, bf->data, bf->len)) {
+            *bytes += (long)bf->len;
+            tokens += lex_reader(&tr);
+            ti_close(&tr);
+        }
+        bio_release(&ld, bf);
+    }
+    bio_close(&ld);
+    return tokens;
+}
+
+/* Returns 0 if this OS gives no way to do it. */
+static int drop_cache(char **paths, int n)
+{
+#if defined(__linux__)
+    int i, fd;
+    for (i = 0; i < n; i++) {
+        fd = open(paths[i], O_RDONLY);
+        if (fd < 0) continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    return 1;
+#else
+    (void)paths;
+    (void)n;
+    return 0;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    static const char *mode_name[3] = { "stdio, one file at a time", "batch, thread pool", "batch, io_uring" };
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    char **paths;
+    int i, mode, cold, rep;
+    long tokens, bytes, expect = -1;
+    double t, best;
+
+    if (n < 1) n = 1;
+    make_dir(BENCH_DIR);
+    paths = (char **)malloc(n * sizeof(char *));
+    for (i = 0; i < n; i++) {
+        paths[i] = (char *)malloc(64);
+        sprintf(paths[i], BENCH_DIR "/f%05d.c", i);
+        write_source(paths[i], i);
+    }
+#ifndef _WIN32
+    sync();     /* only clean pages can be dropped from the cache */
+#endif
+
+    printf("%d files\n", n);
+    printf("%-28s %-6s %12s %10s %12s\n", "reader", "cache", "files/s", "MB/s", "tokens");
+    for (mode = 0; mode < 3; mode++) {
+        for (cold = 1; cold >= 0; cold--) {
+            best = 1e30;
+            tokens = 0;
+            bytes = 0;
+            for (rep = 0; rep < REPS; rep++) {
+                if (cold && !drop_cache(paths, n)) break;
+                t = wall_seconds();
+                if (mode == 0)
+                    tokens = run_stdio(paths, n, &bytes);
+                else
+                    tokens = run_batch(paths, n, mode == 1 ? BIO_THREAD_POOL : BIO_URING, &bytes);
+                t = wall_seconds() - t;
+                if (tokens < 0) break;
+                if (t < best) best = t;
+            }
+            if (tokens < 0) {
+                printf("%-28s %-6s %12s\n", mode_name[mode], "", "not available");
+                break;
+            }
+            if (best == 1e30) {
+                printf("%-28s %-6s %12s\n", mode_name[mode], "cold", "n/a");
+                continue;
+            }
+            printf("%-28s %-6s %12.0f %10.1f %12ld%s\n", mode_name[mode], cold ? "cold" : "warm", n / best,
+                   bytes / best / 1048576.0, tokens, expect >= 0 && tokens != expect ? "  (mismatch!)" : "");
+            if (expect < 0) expect = tokens;
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        remove(paths[i]);
+        free(paths[i]);
+    }
+    free(paths);
+    remove_dir(BENCH_DIR);
+    return 0;
+}
@@ -0,0 +1,242 @@
+/* bench_dfa.c
+    Benchmark for dfa_table.h layouts
+    Prints table bytes and matching MB/s for:
+      - a lexer-shaped token DFA (identifiers, numbers, "..", symbols, blanks)
+      - a large keyword trie DFA with sparse rows
+    Each DFA is measured as a naive states x 256 int table and in every
+    packed layout that fits, plus the layout DFA_AUTO picks.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "dfa_table.h"
+
+#define CORPUS_BYTES (16 * 1024 * 1024)
+#define TRIE_WORDS 3000
+
+typedef struct {
+    int nstates;
+    int cap;
+    int *trans;
+    unsigned char *accept;
+} raw_dfa;
+
+static int raw_add_state(raw_dfa *r, int accepting)
+{
+    int i;
+    if (r->nstates == r->cap) {
+        r->cap = r->cap ? r->cap * 2 : 64;
+        r->trans = (int *)realloc(r->trans, r->cap * 256 * sizeof(int));
+        r->accept = (unsigned char *)realloc(r->accept, r->cap);
+    }
+    for (i = 0; i < 256; i++) r->trans[r->nstates * 256 + i] = -1;
+    r->accept[r->nstates] = (unsigned char)accepting;
+    return r->nstates++;
+}
+
+static void raw_set(raw_dfa *r, int from, const char *bytes, int to)
+{
+    while (*bytes) r->trans[from * 256 + (unsigned char)*bytes++] = to;
+}
+
+static void build_token_dfa(raw_dfa *r)
+{
+    char alpha[64], digit[16], alnum[80];
+    int c, na = 0, nd = 0;
+    int start, ident, num, dot1, stmt_end, sym, ws;
+
+    for (c = 0; c < 256; c++) {
+        if (isalpha(c) || c == '_') alpha[na++] = (char)c;
+        if (isdigit(c)) digit[nd++] = (char)c;
+    }
+    alpha[na] = 0;
+    digit[nd] = 0;
+    strcpy(alnum, alpha);
+    strcat(alnum, digit);
+
+    start = raw_add_state(r, 0);
+    ident = raw_add_state(r, 1);
+    num = raw_add_state(r, 1);
+    dot1 = raw_add_state(r, 0);
+    stmt_end = raw_add_state(r, 1);
+    sym = raw_add_state(r, 1);
+    ws = raw_add_state(r, 1);
+
+    raw_set(r, start, alpha, ident);
+    raw_set(r, ident, alnum, ident);
+    raw_set(r, start, digit, num);
+    raw_set(r, num, digit, num);
+    raw_set(r, start, ".", dot1);
+    raw_set(r, dot1, ".", stmt_end);
+    raw_set(r, start, "(){}=,+-*/<>;:?[]|", sym);
+    raw_set(r, start, " \t\r\n", ws);
+    raw_set(r, ws, " \t\r\n", ws);
+}
+
+static void make_word(char *w, int k)
+{
+    int n = 0;
+    w[n++] = 'k';
+    do {
+        w[n++] = (char)('a' + k % 26);
+        k /= 26;
+    } while (k);
+    w[n++] = 'F';
+    w[n++] = 'n';
+    w[n] = 0;
+}
+
+static void build_trie_dfa(raw_dfa *r)
+{
+    char w[32];
+    int k, i, s, start;
+
+    start = raw_add_state(r, 0);
+    for (k = 0; k < TRIE_WORDS; k++) {
+        make_word(w, k * 7919);
+        s = start;
+        for (i = 0; w[i]; i++) {
+            int t = r->trans[s * 256 + (unsigned char)w[i]];
+            if (t < 0) {
+                t = raw_add_state(r, 0);
+                r->trans[s * 256 + (unsigned char)w[i]] = t;
+            }
+            s = t;
+        }
+        r->accept[s] = 1;
+    }
+    s = raw_add_state(r, 1);
+    raw_set(r, start, " ", s);
+}
+
+static char *token_corpus(int n)
+{
+    static const char *lines[] = {
+        "dec _input3k = 10..\n",
+        "while (dec _loopin0x < 3..) {\n",
+        "    printf(_result4m)..\n",
+        "int _temp2x = _val1a + 5;\n",
+        "loop_main01: break..\n",
+        "return 0..\n"
+    };
+    char *buf = (char *)malloc(n + 1);
+    int i = 0, k = 0, len;
+    while (i < n) {
+        len = (int)strlen(lines[k % 6]);
+        if (len > n - i) len = n - i;
+        memcpy(buf + i, lines[k % 6], len);
+        i += len;
+        k++;
+    }
+    buf[n] = 0;
+    return buf;
+}
+
+static char *trie_corpus(int n)
+{
+    char *buf = (char *)malloc(n + 1);
+    char w[32];
+    int i = 0, k = 0, len;
+    while (i < n) {
+        make_word(w, ((k * 31) % TRIE_WORDS) * 7919);
+        strcat(w, " ");
+        len = (int)strlen(w);
+        if (len > n - i) len = n - i;
+        memcpy(buf + i, w, len);
+        i += len;
+        k++;
+    }
+    buf[n] = 0;
+    return buf;
+}
+
+static int naive_match_len(const raw_dfa *r, const char *s, int n)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    int st = 0, i, last = r->accept[0] ? 0 : -1;
+    for (i = 0; i < n; i++) {
+        st = r->trans[st * 256 + p[i]];
+        if (st < 0) break;
+        if (r->accept[st]) last = i + 1;
+    }
+    return last;
+}
+
+static void report(const char *name, long bytes, long tokens, clock_t t0, clock_t t1, int n)
+{
+    double secs = (double)(t1 - t0) / CLOCKS_PER_SEC;
+    if (secs <= 0) secs = 1e-9;
+    printf("  %-12s %10ld bytes %10ld tokens %10.1f MB/s\n",
+           name, bytes, tokens, n / secs / (1024.0 * 1024.0));
+}
+
+static void bench(const char *title, raw_dfa *r, const char *text, int n)
+{
+    static const int layouts[] = { DFA_DENSE8, DFA_DENSE16, DFA_COMB16, DFA_AUTO };
+    dfa_table d;
+    clock_t t0, t1;
+    long tokens;
+    int i, k, len;
+    char name[32];
+
+    printf("%s: %d states\n", title, r->nstates);
+
+    tokens = 0;
+    t0 = clock();
+    for (i = 0; i < n; i += len > 0 ? len : 1, tokens++)
+        len = naive_match_len(r, text + i, n - i);
+    t1 = clock();
+    report("naive-int", (long)r->nstates * 256 * (long)sizeof(int), tokens, t0, t1, n);
+
+    for (k = 0; k < 4; k++) {
+        if (dfa_build(&d, r->nstates, r->trans, r->accept, 0, layouts[k]) != 0) {
+            printf("  %-12s (does not fit)\n", dfa_layout_name(layouts[k]));
+            continue;
+        }
+        if (!dfa_accepts(&d, text, naive_match_len(r, text, n))) {
+            printf("  %-12s MISMATCH against the naive table\n", dfa_layout_name(d.layout));
+            dfa_free(&d);
+            continue;
+        }
+        tokens = 0;
+        t0 = clock();
+        for (i = 0; i < n; i += len > 0 ? len : 1, tokens++)
+            len = dfa_match_len(&d, text + i, n - i);
+        t1 = clock();
+        if (layouts[k] == DFA_AUTO)
+            snprintf(name, sizeof(name), "auto=%s", dfa_layout_name(d.layout));
+        else
+            snprintf(name, sizeof(name), "%s", dfa_layout_name(d.layout));
+        report(name, dfa_table_bytes(&d), tokens, t0, t1, n);
+        if (k == 3) printf("  byte classes: %d\n", d.nclasses);
+        dfa_free(&d);
+    }
+}
+
+int main(void)
+{
+    raw_dfa tok, trie;
+    char *text;
+
+    memset(&tok, 0, sizeof(tok));
+    memset(&trie, 0, sizeof(trie));
+    build_token_dfa(&tok);
+    build_trie_dfa(&trie);
+
+    text = token_corpus(CORPUS_BYTES);
+    bench("token DFA", &tok, text, CORPUS_BYTES);
+    free(text);
+
+    text = trie_corpus(CORPUS_BYTES);
+    bench("keyword trie DFA", &trie, text, CORPUS_BYTES);
+    free(text);
+
+    free(tok.trans);
+    free(tok.accept);
+    free(trie.trans);
+    free(trie.accept);
+    return 0;
+}
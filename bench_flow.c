@@ -0,0 +1,250 @@
+/* bench_flow.c
+    Benchmark for the control-flow checks of the semantic pass (flow.h)
+    Generates programs made of functions of about 50 basic blocks each
+    (loops with labeled breaks, if/else, switch), doubling the total
+    number of blocks each round, and times sem_line over the text; the
+    time per block should stay flat as the program grows.  A second
+    table keeps 100k blocks in all but makes the functions larger; the
+    time per block should stay flat there too.  A third puts thousands of
+    variables whose values cross the whole function into one function of
+    100k blocks: the dataflow's worst case, where the time grows with the
+    variables, at a 64th of the cost of solving each on its own.
+    Before timing, a table of small functions checks the flow messages.
+    Usage: bench_flow.exe [max-blocks]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np for memprof.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "semantic.h"
+#include "thread_compat.h"
+
+#define REPS 3
+
+typedef struct {
+    char *text;
+    size_t used, cap;
+} text_buf;
+
+static void put(text_buf *b, const char *s)
+{
+    size_t n = strlen(s);
+    if (b->used + n + 1 > b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 1 << 20;
+        while (b->cap < b->used + n + 1) b->cap *= 2;
+        b->text = (char *)realloc(b->text, b->cap);
+        if (!b->text) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(b->text + b->used, s, n + 1);
+    b->used += n;
+}
+
+/* letters-only spelling of i, so names match the FUNC_NAME rule */
+static void letters(char *out, long i)
+{
+    static const char abc[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    int n = 0;
+    do {
+        out[n++] = abc[i % 52];
+        i /= 52;
+    } while (i);
+    out[n] = 0;
+}
+
+/* one unit is 18 blocks: a labeled loop holding an if/else and an inner
+   loop that breaks out of both, then a switch */
+static void put_unit(text_buf *b)
+{
+    put(b, "    loop_walk01:\n"
+           "    while (_i1a < 3) {\n"
+           "        if (_i1a > 1) _s1a = _s1a + _i1a..\n"
+           "        else _s1a = _s1a - 1..\n"
+           "        while (_s1a < 2) {\n"
+           "            break loop_walk01..\n"
+           "        }\n"
+           "        _i1a = _i1a + 1..\n"
+           "    }\n"
+           "    switch (_s1a) {\n"
+           "    case 1: _t1a = 2.. break..\n"
+           "    case 2: _t1a = _i1a.. break..\n"
+           "    default: _t1a = _s1a..\n"
+           "    }\n"
+           "    printf(_t1a)..\n");
+}
+
+/* Small functions and the flow messages they must get, "line: text",
+   in source order.  A declaration's initial value is a store like any
+   other; a counter declared in a loop condition is not one. */
+static const struct {
+    const char *src;
+    const char *want[3];
+} cases[] = {
+    { "int main() {\n    int _a1b = 3..\n    _a1b = 5..\n    return 0..\n}\n",
+      { "2: warning: value assigned to '_a1b' is never read", "3: warning: value assigned to '_a1b' is never read" } },
+    { "int main() {\n    int _c1a = 1..\n    int _a1b = 3..\n    if (_c1a > 0) _a1b = 5..\n    else _a1b = 6..\n"
+      "    return _a1b..\n}\n",
+      { "3: warning: value assigned to '_a1b' is never read" } },
+    { "int main() {\n    int _c1a = 1..\n    int _a1b = 3..\n    if (_c1a > 0) _a1b = 5..\n    return _a1b..\n}\n",
+      { NULL } },
+    { "int main() {\n    int _c1a = 1..\n    int _a1b..\n    if (_c1a > 0) _a1b = 5..\n    return _a1b..\n}\n",
+      { "5: '_a1b' may be used before it is assigned" } },
+    { "int main() {\n    int _a1b = 0..\n    while (_a1b < 3) {\n        _a1b = _a1b + 1..\n    }\n    return 0..\n}\n",
+      { NULL } },
+    { "int main() {\n    int _s1a = 0..\n    while (dec _i1a < 3) {\n        _s1a = _s1a + 1..\n        break..\n    }\n"
+      "    return _s1a..\n}\n",
+      { NULL } },
+};
+
+static int check_cases(void)
+{
+    int c, i, bad = 0;
+
+    for (c = 0; c < (int)(sizeof(cases) / sizeof(cases[0])); c++) {
+        const char *src = cases[c].src, *p = src, *nl;
+        char line[256], got[256];
+        sem_state s;
+
+        sem_init(&s);
+        while ((nl = strchr(p, '\n')) != NULL) {
+            memcpy(line, p, nl - p);
+            line[nl - p] = 0;
+            sem_line(&s, line, (sm_pos)(p - src));
+            p = nl + 1;
+        }
+        sem_finish(&s);
+        for (i = 0; i < s.ndiag; i++) {
+            int lineno = 1;
+            for (p = src; p < src + s.diag[i].pos; p++) lineno += *p == '\n';
+            sprintf(got, "%d: %s", lineno, s.diag[i].text);
+            if (i >= 3 || !cases[c].want[i] || strcmp(got, cases[c].want[i]) != 0) {
+                printf("flow check %d: unexpected \"%s\"\n", c + 1, got);
+                bad++;
+            }
+        }
+        for (i = 0; i < 3 && cases[c].want[i]; i++)
+            if (i >= s.ndiag) {
+                printf("flow check %d: missing \"%s\"\n", c + 1, cases[c].want[i]);
+                bad++;
+            }
+        sem_free(&s);
+    }
+    printf("flow check: %s\n\n", bad ? "FAILED" : "ok");
+    return bad;
+}
+
+/* functions of units_per_func units until about blocks blocks in all */
+static void make_program(text_buf *b, long blocks, int units_per_func)
+{
+    char line[128], fn[16];
+    long units = (blocks + 17) / 18, u = 0, f;
+    int k;
+
+    b->used = 0;
+    put(b, "#include<stdio.h>\n");
+    for (f = 0; u < units; f++) {
+        letters(fn, f);
+        sprintf(line, "int %sFn(int _arg1a) {\n", fn);
+        put(b, line);
+        put(b, "    int _i1a = _arg1a..\n    int _s1a = 0..\n    int _t1a..\n");
+        for (k = 0; k < units_per_func && u < units; k++, u++) put_unit(b);
+        put(b, "    return _s1a..\n}\n");
+    }
+    put(b, "int main() {\n    int _res1r = aFn(1)..\n    return _res1r..\n}\n");
+}
+
+/* one function of about blocks blocks with vars more variables, declared
+   at its top and read at its end: half initialized there, half assigned
+   just before the reads, so both dataflow problems carry every one of
+   them across the whole function */
+static void make_wide(text_buf *b, long blocks, int vars)
+{
+    char line[128], name[16];
+    long units = (blocks + 17) / 18, u;
+    int k;
+
+    b->used = 0;
+    put(b, "#include<stdio.h>\nint wideFn(int _arg1a) {\n");
+    put(b, "    int _i1a = _arg1a..\n    int _s1a = 0..\n    int _t1a..\n");
+    for (k = 0; k < vars; k++) {
+        letters(name, k);
+        sprintf(line, k % 2 ? "    int _w%s1a..\n" : "    int _w%s1a = _arg1a..\n", name);
+        put(b, line);
+    }
+    for (u = 0; u < units; u++) put_unit(b);
+    for (k = 1; k < vars; k += 2) {
+        letters(name, k);
+        sprintf(line, "    _w%s1a = %d..\n", name, k);
+        put(b, line);
+    }
+    for (k = 0; k < vars; k++) {
+        letters(name, k);
+        sprintf(line, "    if (_arg1a > %d) _s1a = _s1a + _w%s1a..\n", k, name);
+        put(b, line);
+    }
+    put(b, "    return _s1a..\n}\nint main() {\n    int _res1r = wideFn(1)..\n    return _res1r..\n}\n");
+}
+
+static double time_pass(text_buf *b, int *messages, long *blocks)
+{
+    sem_state s;
+    char *p = b->text, *nl;
+    double t0 = wall_seconds();
+
+    sem_init(&s);
+    while ((nl = strchr(p, '\n')) != NULL) {
+        *nl = 0;
+        sem_line(&s, p, (sm_pos)(p - b->text));
+        *nl = '\n';
+        p = nl + 1;
+    }
+    *messages = sem_finish(&s) + s.warnings;
+    *blocks = s.flow.blocks_total;
+    sem_free(&s);
+    return wall_seconds() - t0;
+}
+
+/* times the program in b; second is the second column */
+static void run(text_buf *b, long second)
+{
+    double best = 1e30, t;
+    long blocks;
+    int messages, rep;
+
+    for (rep = 0; rep < REPS; rep++) {
+        t = time_pass(b, &messages, &blocks);
+        if (t < best) best = t;
+    }
+    printf("%10ld %12ld %10.1f %10.3f %10.1f%s\n", blocks, second, b->used / 1048576.0, best,
+           best * 1e9 / blocks, messages ? "  (messages!)" : "");
+}
+
+int main(int argc, char **argv)
+{
+    long max = argc > 1 ? atol(argv[1]) : 800000;
+    text_buf b = { NULL, 0, 0 };
+    long n;
+    int units, vars;
+
+    if (check_cases()) return 1;
+    printf("%10s %12s %10s %10s %10s\n", "blocks", "blocks/func", "MB", "seconds", "ns/block");
+    for (n = 25000; n <= max; n *= 2) {
+        make_program(&b, n, 3);
+        run(&b, 3 * 18 + 3);
+    }
+    printf("\n");
+    for (units = 3; units <= 192; units *= 4) {
+        make_program(&b, 100000, units);
+        run(&b, units * 18 + 3);
+    }
+    printf("\n%10s %12s %10s %10s %10s\n", "blocks", "variables", "MB", "seconds", "ns/block");
+    for (vars = 1000; vars <= 16000; vars *= 2) {
+        make_wide(&b, 100000, vars);
+        run(&b, vars);
+    }
+    free(b.text);
+    return 0;
+}
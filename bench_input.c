@@ -0,0 +1,241 @@
+/* bench_input.c
+    Benchmark for the lexer input layer (text_input.h)
+    Times the kernels on an in-memory source corpus, against memcpy of
+    the same bytes as a memory bandwidth yardstick:
+      - UTF-8 validation of ASCII text and of text with non-ASCII strings
+      - UTF-16 LE and BE to UTF-8 transcoding of the same two texts
+    then reads the corpus back from a file in each encoding through
+    ti_getline, next to plain fgets.
+    Usage: bench_input.exe [megabytes]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np for memprof.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "text_input.h"
+#include "thread_compat.h"
+
+#define BENCH_FILE "bench_input_data.txt"
+#define REPS 5
+
+static char *make_corpus(size_t n, int unicode)
+{
+    static const char *ascii[] = {
+        "int computeValueFn(int _val1a) {\n",
+        "    int _temp2x = _val1a + 5;\n",
+        "    printf(\"Result: %d\\n\", _temp2x);\n",
+        "    while (_loopin0x < 3) {\n",
+        "    }\n"
+    };
+    /* "Résultat € 😀" in UTF-8 */
+    static const char *wide = "    printf(\"R\xC3\xA9sultat \xE2\x82\xAC \xF0\x9F\x98\x80: %d\\n\", _temp2x);\n";
+    char *buf = (char *)malloc(n + 1);
+    size_t i = 0, len;
+    int k = 0;
+    const char *s;
+
+    if (!buf) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    while (i < n) {
+        s = unicode && k % 5 == 2 ? wide : ascii[k % 5];
+        len = strlen(s);
+        if (len > n - i) len = n - i;
+        memcpy(buf + i, s, len);
+        i += len;
+        k++;
+    }
+    /* never end on half a character */
+    while (n > 0 && ((unsigned char)buf[n - 1] & 0x80)) buf[--n] = ' ';
+    buf[n] = 0;
+    return buf;
+}
+
+/* UTF-8 -> UTF-16 for the test data; the corpus only has BMP and one
+   astral character, so the straightforward decoder is enough */
+static unsigned char *to_utf16(const char *s, size_t n, int big_endian, size_t *out)
+{
+    unsigned char *d = (unsigned char *)malloc(2 * n + 2);
+    const unsigned char *p = (const unsigned char *)s;
+    size_t i = 0, o = 0;
+    unsigned long cp, units[2];
+    int nu, u;
+
+    while (i < n) {
+        if (p[i] < 0x80) {
+            cp = p[i++];
+        } else if (p[i] < 0xE0) {
+            cp = (p[i] & 0x1F) << 6 | (p[i + 1] & 0x3F);
+            i += 2;
+        } else if (p[i] < 0xF0) {
+            cp = (unsigned long)(p[i] & 0x0F) << 12 | (p[i + 1] & 0x3F) << 6 | (p[i + 2] & 0x3F);
+            i += 3;
+        } else {
+            cp = (unsigned long)(p[i] & 0x07) << 18 | (unsigned long)(p[i + 1] & 0x3F) << 12 |
+                 (p[i + 2] & 0x3F) << 6 | (p[i + 3] & 0x3F);
+            i += 4;
+        }
+        if (cp >= 0x10000) {
+            units[0] = 0xD800 + ((cp - 0x10000) >> 10);
+            units[1] = 0xDC00 + ((cp - 0x10000) & 0x3FF);
+            nu = 2;
+        } else {
+            units[0] = cp;
+            nu = 1;
+        }
+        for (u = 0; u < nu; u++) {
+            d[o++] = (unsigned char)(big_endian ? units[u] >> 8 : units[u] & 0xFF);
+            d[o++] = (unsigned char)(big_endian ? units[u] & 0xFF : units[u] >> 8);
+        }
+    }
+    *out = o;
+    return d;
+}
+
+static void report(const char *what, size_t bytes, double secs)
+{
+    printf("  %-34s %8.2f GB/s\n", what, bytes / secs / 1e9);
+}
+
+static void bench_kernels(const char *label, const char *text, size_t n)
+{
+    char *dst = (char *)malloc(2 * n + 16);
+    unsigned char *u16;
+    size_t u16_len, out;
+    double t, best;
+    int rep, bad, be;
+    char what[64];
+
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        t = wall_seconds();
+        memcpy(dst, text, n);
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    sprintf(what, "memcpy (%s)", label);
+    report(what, n, best);
+
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        t = wall_seconds();
+        if (ti_utf8_check((const unsigned char *)text, n, 1, &bad) != n || bad) printf("  unexpected invalid UTF-8\n");
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    sprintf(what, "UTF-8 validate (%s)", label);
+    report(what, n, best);
+
+    for (be = 0; be < 2; be++) {
+        u16 = to_utf16(text, n, be, &u16_len);
+        best = 1e30;
+        for (rep = 0; rep < REPS; rep++) {
+            t = wall_seconds();
+            ti_utf16_to_utf8(u16, u16_len, be, 1, dst, &out, &bad);
+            t = wall_seconds() - t;
+            if (t < best) best = t;
+        }
+        if (out != n || bad || memcmp(dst, text, n) != 0) printf("  UTF-16 round trip mismatch\n");
+        /* GB/s of UTF-16 input */
+        sprintf(what, "UTF-16 %s -> UTF-8 (%s)", be ? "BE" : "LE", label);
+        report(what, u16_len, best);
+        free(u16);
+    }
+    free(dst);
+}
+
+static void write_file(const char *path, const void *bom, size_t bom_len, const void *data, size_t n)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror("fopen");
+        exit(1);
+    }
+    fwrite(bom, 1, bom_len, f);
+    fwrite(data, 1, n, f);
+    fclose(f);
+}
+
+static double time_getline(const char *path, long *lines)
+{
+    FILE *f = fopen(path, "rb");
+    ti_reader tr;
+    double t0 = wall_seconds();
+
+    *lines = 0;
+    ti_open(&tr, f);
+    while (ti_getline(&tr, TI_MAXLINE)) (*lines)++;
+    if (tr.err) printf("  %s\n", tr.err);
+    ti_close(&tr);
+    fclose(f);
+    return wall_seconds() - t0;
+}
+
+static double time_fgets(const char *path, long *lines)
+{
+    FILE *f = fopen(path, "rb");
+    char line[TI_MAXLINE];
+    double t0 = wall_seconds();
+
+    *lines = 0;
+    while (fgets(line, sizeof(line), f)) (*lines)++;
+    fclose(f);
+    return wall_seconds() - t0;
+}
+
+static void bench_files(const char *text, size_t n)
+{
+    static const unsigned char bom16le[] = { 0xFF, 0xFE }, bom16be[] = { 0xFE, 0xFF };
+    unsigned char *u16;
+    size_t u16_len;
+    long lines;
+    double t, best;
+    int rep, enc;
+
+    for (enc = 0; enc < 3; enc++) {
+        if (enc == TI_UTF8) {
+            write_file(BENCH_FILE, "", 0, text, n);
+            u16_len = n;
+        } else {
+            u16 = to_utf16(text, n, enc == TI_UTF16BE, &u16_len);
+            write_file(BENCH_FILE, enc == TI_UTF16BE ? bom16be : bom16le, 2, u16, u16_len);
+            free(u16);
+        }
+        if (enc == TI_UTF8) {
+            best = 1e30;
+            for (rep = 0; rep < REPS; rep++) {
+                t = time_fgets(BENCH_FILE, &lines);
+                if (t < best) best = t;
+            }
+            printf("  %-20s %-13s %8.2f GB/s  (%ld lines)\n", "fgets", "UTF-8", n / best / 1e9, lines);
+        }
+        best = 1e30;
+        for (rep = 0; rep < REPS; rep++) {
+            t = time_getline(BENCH_FILE, &lines);
+            if (t < best) best = t;
+        }
+        printf("  %-20s %-13s %8.2f GB/s  (%ld lines)\n", "ti_getline", ti_encoding_name[enc], u16_len / best / 1e9, lines);
+    }
+    remove(BENCH_FILE);
+}
+
+int main(int argc, char **argv)
+{
+    size_t mb = argc > 1 ? (size_t)atol(argv[1]) : 64;
+    size_t n = mb << 20;
+    char *ascii = make_corpus(n, 0);
+    char *mixed = make_corpus(n, 1);
+
+    printf("kernels, %lu MB of source text:\n", (unsigned long)mb);
+    bench_kernels("ASCII", ascii, strlen(ascii));
+    bench_kernels("mixed", mixed, strlen(mixed));
+    printf("\nfile read, warm page cache:\n");
+    bench_files(ascii, strlen(ascii));
+    printf("  with non-ASCII strings:\n");
+    bench_files(mixed, strlen(mixed));
+    free(ascii);
+    free(mixed);
+    return 0;
+}
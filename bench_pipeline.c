@@ -0,0 +1,124 @@
+/* bench_pipeline.c
+    Benchmark for project_parser.exe --pipeline (pipeline.h)
+    Writes a large generated DSL program, then times on it:
+      - lexing only (lexer_core.h)
+      - parsing only (parser_core.h line checks)
+      - the pipelined lexer -> parser run
+    and compares the pipeline against lex + parse and max(lex, parse).
+    Usage: bench_pipeline.exe [lines]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np for memprof.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipeline.h"
+
+#define BENCH_FILE "bench_pipeline_input.txt"
+
+static void count_token(void *ctx, const char *tok, const char *lex)
+{
+    (void)tok;
+    (void)lex;
+    (*(long *)ctx)++;
+}
+
+static void write_input(const char *path, long lines)
+{
+    static const char *body[] = {
+        "    dec _input3k = 10..\n",
+        "    int _temp2x = _val1a + 5;\n",
+        "    printf(\"Value: %d\\n\", _temp2x);\n",
+        "    while (dec _loopin0x < 3..) {\n",
+        "        printf(_input3k)..\n",
+        "        // loop body text\n",
+        "        break..\n",
+        "    }\n"
+    };
+    FILE *f = fopen(path, "w");
+    long i;
+    if (!f) {
+        perror("fopen");
+        exit(1);
+    }
+    fprintf(f, "#include<stdio.h>\nint main() {\n");
+    for (i = 0; i < lines; i++) fputs(body[i % 8], f);
+    fprintf(f, "    return 0..\n}\n");
+    fclose(f);
+}
+
+static double time_lex(const char *path, long *tokens)
+{
+    char line[MAXLINE];
+    lex_state ls;
+    FILE *f = fopen(path, "r");
+    double t0 = wall_seconds();
+    int lineno = 0;
+
+    *tokens = 0;
+    lex_init(&ls, count_token, tokens);
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        if (!lex_line(&ls, line, ++lineno)) printf("lexer: %s\n", ls.err);
+    }
+    fclose(f);
+    return wall_seconds() - t0;
+}
+
+static double time_parse(const char *path)
+{
+    char line[MAXLINE];
+    FILE *f = fopen(path, "r");
+    double t0 = wall_seconds();
+    int lineno = 0, main_seen = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (line_has_main(line)) main_seen = 1;
+        if (!validate_line(line, ++lineno)) printf("parser: %s\n", parse_diag);
+    }
+    fclose(f);
+    if (!main_seen) printf("parser: main not found\n");
+    return wall_seconds() - t0;
+}
+
+static double time_pipeline(const char *path, pipe_result *r)
+{
+    FILE *f = fopen(path, "rb");
+    double t0 = wall_seconds();
+    if (pipeline_parse(f, r, NULL) != 0) printf("pipeline: could not start lexer thread\n");
+    fclose(f);
+    return wall_seconds() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    long lines = argc > 1 ? atol(argv[1]) : 2000000;
+    long tokens;
+    double lex, parse, pipe, best;
+    pipe_result r;
+    int rep;
+
+    write_input(BENCH_FILE, lines);
+    /* warm the page cache so every run reads from memory */
+    time_parse(BENCH_FILE);
+
+    lex = parse = pipe = 1e30;
+    for (rep = 0; rep < 3; rep++) {
+        best = time_lex(BENCH_FILE, &tokens);
+        if (best < lex) lex = best;
+        best = time_parse(BENCH_FILE);
+        if (best < parse) parse = best;
+        best = time_pipeline(BENCH_FILE, &r);
+        if (best < pipe) pipe = best;
+    }
+
+    printf("input: %ld lines, %ld tokens\n", lines + 4, tokens);
+    printf("  lex only          %8.3f s\n", lex);
+    printf("  parse only        %8.3f s\n", parse);
+    printf("  lex + parse       %8.3f s\n", lex + parse);
+    printf("  max(lex, parse)   %8.3f s\n", lex > parse ? lex : parse);
+    printf("  pipelined         %8.3f s  (%s, %ld tokens)\n", pipe,
+           r.lex_ok && r.include_ok && r.has_main && r.structure_ok ? "ACCEPTED" : "REJECTED", r.tokens);
+    remove(BENCH_FILE);
+    return 0;
+}
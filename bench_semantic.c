@@ -0,0 +1,193 @@
+/* bench_semantic.c
+    Benchmark for the semantic pass of project_parser.exe (semantic.h)
+    Generates programs whose functions each declare a run of distinct
+    variables (plus a loop scope per function), doubling the number of
+    distinct identifiers each round, and times sem_line over the text.
+    Time per identifier should stay flat as the input grows.
+    First it checks the messages for a small program with dec values
+    stored into ints (exits 1 if they are not the expected ones, in
+    source order).
+    Usage: bench_semantic.exe [max-identifiers]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np for memprof.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "semantic.h"
+#include "thread_compat.h"
+
+#define VARS_PER_FUNC 1000
+
+typedef struct {
+    char *text;
+    size_t used, cap;
+} text_buf;
+
+static void put(text_buf *b, const char *s)
+{
+    size_t n = strlen(s);
+    if (b->used + n + 1 > b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 1 << 20;
+        while (b->cap < b->used + n + 1) b->cap *= 2;
+        b->text = (char *)realloc(b->text, b->cap);
+        if (!b->text) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(b->text + b->used, s, n + 1);
+    b->used += n;
+}
+
+static void ignore_token(void *ctx, const char *tok, const char *lex)
+{
+    (void)ctx;
+    (void)tok;
+    (void)lex;
+}
+
+/* letters-only spelling of i, so names match the VAR and FUNC_NAME rules */
+static void letters(char *out, long i)
+{
+    static const char abc[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    int n = 0;
+    do {
+        out[n++] = abc[i % 52];
+        i /= 52;
+    } while (i);
+    out[n] = 0;
+}
+
+static void make_program(text_buf *b, long idents)
+{
+    char line[256], name[16], prev[32], fn[16];
+    long v = 0, f;
+
+    b->used = 0;
+    put(b, "#include<stdio.h>\n");
+    for (f = 0; v < idents; f++) {
+        int k;
+        letters(fn, f);
+        sprintf(line, "int %sFn(int _arg%s1a) {\n", fn, fn);
+        put(b, line);
+        sprintf(prev, "_arg%s1a", fn);
+        for (k = 0; k < VARS_PER_FUNC && v < idents; k++, v++) {
+            letters(name, v);
+            sprintf(line, "    int _%s1v = %s + %d;\n", name, prev, k);
+            put(b, line);
+            sprintf(prev, "_%s1v", name);
+        }
+        sprintf(line, "    while (%s < 3) {\n        int _tmp1t = %s..\n        printf(_tmp1t)..\n    }\n", prev, prev);
+        put(b, line);
+        sprintf(line, "    return %s;\n}\n", prev);
+        put(b, line);
+    }
+    put(b, "int main() {\n    int _res1r = aFn(1);\n    return _res1r;\n}\n");
+}
+
+/* A dec literal (2.5) is a lexer error, so dec values reach an int only
+   through dec variables and dec functions; lateFn is settled by sem_finish
+   after the other lines, and halfFn is declared after its use. */
+static void check_messages(void)
+{
+    static const char *const src[] = {
+        "#include<stdio.h>",
+        "int main() {",
+        "    dec _d1a = 3..",
+        "    int _i1a = _d1a..",
+        "    int _k1a = lateFn(_i1a)..",
+        "    int _j1a = halfFn(_k1a)..",
+        "    _i1a = _d1a + _j1a..",
+        "    return _i1a..",
+        "}",
+        "dec halfFn(dec _x1a) {",
+        "    return _x1a..",
+        "}",
+    };
+    static const struct { int line; const char *text; } want[] = {
+        {4, "type mismatch, dec value '_d1a' used as int"},
+        {5, "call to undeclared function 'lateFn'"},
+        {6, "type mismatch, dec value 'halfFn' used as int"},
+        {7, "type mismatch, dec value '_d1a' used as int"},
+    };
+    int nsrc = (int)(sizeof(src) / sizeof(src[0]));
+    int nwant = (int)(sizeof(want) / sizeof(want[0]));
+    sm_pos start[sizeof(src) / sizeof(src[0])];
+    lex_tok tok[LEX_MAXLINE];
+    lex_state ls;
+    sem_state s;
+    sm_pos pos = 0;
+    int i, line, errors, ok = 1;
+
+    lex_init(&ls, ignore_token, NULL);
+    ls.tok = tok;
+    sem_init(&s);
+    for (i = 0; i < nsrc; i++) {
+        start[i] = pos;
+        if (!lex_line(&ls, src[i], i + 1)) {
+            printf("message check: line %d: %s\n", i + 1, ls.err);
+            exit(1);
+        }
+        sem_line_tokens(&s, src[i], pos, tok, ls.ntok);
+        pos += (sm_pos)strlen(src[i]) + 1;
+    }
+    errors = sem_finish(&s);
+    if (errors != nwant || s.ndiag != nwant) ok = 0;
+    for (i = 0; ok && i < nwant; i++) {
+        line = nsrc;
+        while (line > 1 && start[line - 1] > s.diag[i].pos) line--;
+        if (line != want[i].line || strcmp(s.diag[i].text, want[i].text) != 0) ok = 0;
+    }
+    if (!ok) {
+        printf("message check: FAILED, got %d errors:\n", errors);
+        for (i = 0; i < s.ndiag; i++) printf("  @%u %s\n", (unsigned)s.diag[i].pos, s.diag[i].text);
+        exit(1);
+    }
+    sem_free(&s);
+    printf("message check: ok\n");
+}
+
+static double time_pass(text_buf *b, int *errors, long *lines)
+{
+    sem_state s;
+    char *p = b->text, *nl;
+    int lineno = 0;
+    double t0 = wall_seconds();
+
+    sem_init(&s);
+    while ((nl = strchr(p, '\n')) != NULL) {
+        *nl = 0;
+        sem_line(&s, p, (sm_pos)(p - b->text));
+        lineno++;
+        *nl = '\n';
+        p = nl + 1;
+    }
+    *errors = sem_finish(&s);
+    sem_free(&s);
+    *lines = lineno;
+    return wall_seconds() - t0;
+}
+
+int main(int argc, char **argv)
+{
+    long max = argc > 1 ? atol(argv[1]) : 1600000;
+    text_buf b = { NULL, 0, 0 };
+    long n, lines;
+    int errors, rep;
+
+    check_messages();
+    printf("%12s %10s %10s %10s %12s\n", "identifiers", "lines", "MB", "seconds", "ns/ident");
+    for (n = 25000; n <= max; n *= 2) {
+        double best = 1e30, t;
+        make_program(&b, n);
+        for (rep = 0; rep < 3; rep++) {
+            t = time_pass(&b, &errors, &lines);
+            if (t < best) best = t;
+        }
+        printf("%12ld %10ld %10.1f %10.3f %12.1f%s\n", n, lines, b.used / 1048576.0, best,
+               best * 1e9 / n, errors ? "  (errors!)" : "");
+    }
+    free(b.text);
+    return 0;
+}
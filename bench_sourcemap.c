@@ -0,0 +1,244 @@
+/* bench_sourcemap.c
+    Benchmark for the diagnostics source map (source_map.h)
+    Writes a few generated DSL files with millions of lines in all, maps
+    them into memory and times:
+      - building one map over all of them (sm_add_text on the mapped
+        files), next to a byte-at-a-time newline loop
+      - the same from FILEs (sm_add_stream)
+      - random offset -> line/column lookups through the bucket table,
+        next to a plain binary search over the line starts
+    Usage: bench_sourcemap.exe [million-lines]
+*/
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np for memprof.h */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "source_map.h"
+#include "thread_compat.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define NFILES 4
+#define LOOKUPS 10000000
+#define REPS 3
+
+typedef struct {
+    char path[32];
+    const char *text;
+    size_t len;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    int fd;
+#endif
+} mapped_file;
+
+static void write_source(const char *path, long lines)
+{
+    static const char *body[] = {
+        "    int _val1a = _arg1a + 5..\n",
+        "    printf(\"value: %d\\n\", _val1a)..\n",
+        "    while (_val1a < 3) {\n",
+        "        _val1a = _val1a + 1..\n",
+        "    }\n",
+        "\n"
+    };
+    FILE *f = fopen(path, "wb");
+    long i;
+
+    if (!f) {
+        perror("fopen");
+        exit(1);
+    }
+    fputs("#include<stdio.h>\n", f);
+    for (i = 1; i < lines; i++) fputs(body[i % 6], f);
+    fclose(f);
+}
+
+static int map_file(mapped_file *mf)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    mf->file = CreateFileA(mf->path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (mf->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(mf->file, &size)) return 0;
+    mf->len = (size_t)size.QuadPart;
+    mf->mapping = CreateFileMappingA(mf->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mf->mapping) return 0;
+    mf->text = (const char *)MapViewOfFile(mf->mapping, FILE_MAP_READ, 0, 0, 0);
+    return mf->text != NULL;
+#else
+    struct stat st;
+    void *p;
+    mf->fd = open(mf->path, O_RDONLY);
+    if (mf->fd < 0 || fstat(mf->fd, &st) != 0) return 0;
+    mf->len = (size_t)st.st_size;
+    p = mmap(NULL, mf->len, PROT_READ, MAP_PRIVATE, mf->fd, 0);
+    if (p == MAP_FAILED) return 0;
+    mf->text = (const char *)p;
+    return 1;
+#endif
+}
+
+static void unmap_file(mapped_file *mf)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(mf->text);
+    CloseHandle(mf->mapping);
+    CloseHandle(mf->file);
+#else
+    munmap((void *)mf->text, mf->len);
+    close(mf->fd);
+#endif
+}
+
+/* the scan without SSE2 or memchr, for scale */
+static unsigned naive_scan(sm_pos *out, const char *s, size_t n, sm_pos at)
+{
+    unsigned k = 0;
+    size_t i;
+    out[k++] = at;
+    for (i = 0; i < n; i++)
+        if (s[i] == '\n') out[k++] = at + (sm_pos)(i + 1);
+    return k;
+}
+
+static unsigned bsearch_line(const sm_map *m, sm_pos pos)
+{
+    unsigned lo = 0, hi = m->nlines - 1, mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo + 1) / 2;
+        if (m->start[mid] <= pos) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+static unsigned long rng = 12345;
+
+static unsigned next_rand(void)
+{
+    rng = rng * 1103515245UL + 12345UL;
+    return (unsigned)((rng >> 8) & 0xFFFFFFUL) << 8 ^ (unsigned)(rng >> 20);
+}
+
+int main(int argc, char **argv)
+{
+    long mlines = argc > 1 ? atol(argv[1]) : 4;
+    mapped_file mf[NFILES];
+    sm_map m;
+    sm_pos *probe, *naive;
+    size_t total = 0;
+    unsigned long check, check2;
+    unsigned nnaive = 0;
+    double t, best;
+    int i, rep;
+    long k;
+    FILE *f;
+
+    if (mlines < 1) mlines = 1;
+    for (i = 0; i < NFILES; i++) {
+        sprintf(mf[i].path, "bench_sourcemap_%d.txt", i);
+        write_source(mf[i].path, mlines * 1000000L / NFILES);
+        if (!map_file(&mf[i])) {
+            fprintf(stderr, "cannot map %s\n", mf[i].path);
+            return 1;
+        }
+        total += mf[i].len;
+    }
+    printf("%d files, %ld million lines, %.1f MB\n\n", NFILES, mlines, total / 1048576.0);
+
+    sm_init(&m);
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        sm_reset(&m);
+        t = wall_seconds();
+        for (i = 0; i < NFILES; i++) sm_add_text(&m, mf[i].path, mf[i].text, mf[i].len);
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    printf("  %-30s %8.2f GB/s %8.2f ns/line\n", "build, mapped files", total / best / 1e9, best * 1e9 / m.nlines);
+
+    naive = (sm_pos *)malloc((size_t)(m.nlines + NFILES) * sizeof(sm_pos));
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        sm_pos at = 0;
+        t = wall_seconds();
+        nnaive = 0;
+        for (i = 0; i < NFILES; i++) {
+            nnaive += naive_scan(naive + nnaive, mf[i].text, mf[i].len, at);
+            at += (sm_pos)mf[i].len;
+        }
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    printf("  %-30s %8.2f GB/s %8.2f ns/line\n", "build, byte loop", total / best / 1e9, best * 1e9 / nnaive);
+    if (nnaive != m.nlines || memcmp(naive, m.start, nnaive * sizeof(sm_pos)) != 0) printf("  line tables differ!\n");
+    free(naive);
+
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        sm_reset(&m);
+        t = wall_seconds();
+        for (i = 0; i < NFILES; i++) {
+            f = fopen(mf[i].path, "rb");
+            sm_add_stream(&m, mf[i].path, f);
+            fclose(f);
+        }
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    printf("  %-30s %8.2f GB/s %8.2f ns/line\n", "build, FILE streams", total / best / 1e9, best * 1e9 / m.nlines);
+
+    t = wall_seconds();
+    sm_lookup(&m, 0);
+    t = wall_seconds() - t;
+    printf("  %-30s %8.2f ms  (%.1f bytes per line with the line starts)\n", "bucket table, first lookup", t * 1e3,
+           (double)(m.nlines + m.nbuckets) * 4 / m.nlines);
+
+    probe = (sm_pos *)malloc(LOOKUPS * sizeof(sm_pos));
+    for (k = 0; k < LOOKUPS; k++) probe[k] = (sm_pos)(next_rand() % (unsigned)total);
+
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        check = 0;
+        t = wall_seconds();
+        for (k = 0; k < LOOKUPS; k++) {
+            sm_loc loc = sm_lookup(&m, probe[k]);
+            check += loc.line + loc.col;
+        }
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    printf("  %-30s %8.1f ns\n", "lookup, bucket table", best * 1e9 / LOOKUPS);
+
+    best = 1e30;
+    for (rep = 0; rep < REPS; rep++) {
+        check2 = 0;
+        t = wall_seconds();
+        for (k = 0; k < LOOKUPS; k++) {
+            unsigned line = bsearch_line(&m, probe[k]);
+            unsigned fi = 0;
+            while (fi + 1 < (unsigned)m.nfiles && m.file[fi + 1].first <= line) fi++;
+            check2 += line - m.file[fi].first + 1 + probe[k] - m.start[line] + 1;
+        }
+        t = wall_seconds() - t;
+        if (t < best) best = t;
+    }
+    printf("  %-30s %8.1f ns%s\n", "lookup, binary search", best * 1e9 / LOOKUPS, check == check2 ? "" : "  (mismatch!)");
+
+    free(probe);
+    sm_free(&m);
+    for (i = 0; i < NFILES; i++) {
+        unmap_file(&mf[i]);
+        remove(mf[i].path);
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+/* bench_tokencount.c
+    Throughput benchmark for tokencount (tokencount_core.h)
+    Builds a synthetic DSL/C corpus in memory and counts it with 1 up to
+    cpu_count() threads, first from memory and then from a file written
+    to disk (page cache warm), reporting GB/s for each run.
+    First it checks that tokens placed right at a TC_CHUNK range boundary
+    are counted once, as they are when the input is one range.
+    Usage: bench_tokencount.exe [megabytes]
+*/
+#define _POSIX_C_SOURCE 200809L     /* fseeko under -std=c11 (tokencount_core.h) */
+#define _FILE_OFFSET_BITS 64        /* and 64-bit offsets for it */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tokencount_core.h"
+
+#define BENCH_FILE "bench_tokencount_input.txt"
+
+static char *make_corpus(long long n)
+{
+    static const char *lines[] = {
+        "int computeValueFn(int _val1a) {\n",
+        "    int _temp2x = _val1a + 5;\n",
+        "    dec _input3k = 10..\n",
+        "    while (_loopin0x < 3) {\n",
+        "        printf(\"Result: %d\\n\", _result4m);\n",
+        "        _loopin0x = _loopin0x + 1;\n",
+        "    }\n",
+        "    return _temp2x;\n",
+        "}\n"
+    };
+    char *buf = (char *)malloc((size_t)n + 1);
+    long long i = 0;
+    int k = 0;
+    if (!buf) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    while (i < n) {
+        long long len = (long long)strlen(lines[k % 9]);
+        if (len > n - i) len = n - i;
+        memcpy(buf + i, lines[k % 9], (size_t)len);
+        i += len;
+        k++;
+    }
+    buf[n] = 0;
+    return buf;
+}
+
+/* jobs of TC_CHUNK bytes over mem or path, as tokencount splits a large file */
+static tc_job *make_jobs(const char *mem, const char *path, long long n, int *njobs)
+{
+    tc_job *jobs;
+
+    *njobs = (int)((n + TC_CHUNK - 1) / TC_CHUNK);
+    jobs = (tc_job *)calloc(*njobs, sizeof(tc_job));
+    if (!jobs) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    for (int i = 0; i < *njobs; i++) {
+        jobs[i].mem = mem;
+        jobs[i].mem_len = n;
+        jobs[i].path = path;
+        jobs[i].start = (long long)i * TC_CHUNK;
+        jobs[i].stop = i + 1 < *njobs ? (long long)(i + 1) * TC_CHUNK : -1;
+    }
+    return jobs;
+}
+
+/* Counts text[0..n) split at TC_CHUNK, from memory and from a file, and
+   compares with the expected totals.  Returns the number of mismatches. */
+static int check_split(const char *name, const char *text, long long n, long long identifiers, long long numbers)
+{
+    const char *mem[2] = { text, NULL };
+    const char *path[2] = { NULL, BENCH_FILE };
+    int bad = 0;
+    FILE *f = fopen(BENCH_FILE, "wb");
+
+    if (!f) {
+        perror("fopen");
+        exit(1);
+    }
+    fwrite(text, 1, (size_t)n, f);
+    fclose(f);
+    for (int k = 0; k < 2; k++) {
+        tc_counts c;
+        int njobs;
+        tc_job *jobs = make_jobs(mem[k], path[k], n, &njobs);
+
+        tc_counts_init(&c);
+        tc_run(jobs, njobs, 2, &c);
+        if (c.identifiers != identifiers || c.numbers != numbers) {
+            printf("  FAIL %s (%s): %lld identifiers, %lld numbers; expected %lld, %lld\n", name,
+                   mem[k] ? "memory" : "file", c.identifiers, c.numbers, identifiers, numbers);
+            bad++;
+        }
+        tc_table_free(&c.idents);
+        free(jobs);
+    }
+    remove(BENCH_FILE);
+    return bad;
+}
+
+/* Tokens at, across and just after the first range boundary. */
+static int check_boundaries(void)
+{
+    static const struct {
+        const char *name;
+        char fill;                  /* fills the bytes before the tail */
+        int back;                   /* the tail starts this many bytes before the boundary */
+        const char *tail;
+        long long identifiers, numbers;
+    } cases[] = {
+        { "word at boundary", 'x', 1, " abc foo\n", 2, 0 },
+        { "number at boundary", ' ', 0, "12\n", 0, 1 },
+        { "word across boundary", ' ', 2, "abcd e\n", 2, 0 },
+        { "number across boundary", ' ', 1, "12 3\n", 0, 2 },
+        { "letters after digits at boundary", ' ', 1, "1ab c\n", 2, 1 },
+        { "letters after digits past boundary", ' ', 1, "12ab\n", 1, 1 },
+    };
+    int bad = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        long long at = TC_CHUNK - cases[i].back;
+        long long n = at + (long long)strlen(cases[i].tail);
+        char *text = (char *)malloc((size_t)n + 1);
+
+        if (!text) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        memset(text, cases[i].fill, (size_t)at);
+        strcpy(text + at, cases[i].tail);
+        /* the fill is one more word when it is not blank */
+        bad += check_split(cases[i].name, text, n, cases[i].identifiers + (cases[i].fill != ' '), cases[i].numbers);
+        free(text);
+    }
+    printf("range boundary check: %s\n", bad ? "FAILED" : "ok");
+    return bad;
+}
+
+static void run(const char *label, const char *mem, const char *path, long long n, int threads)
+{
+    tc_job *jobs;
+    tc_counts c;
+    int njobs;
+    double t0, secs;
+
+    jobs = make_jobs(mem, path, n, &njobs);
+    tc_counts_init(&c);
+    t0 = wall_seconds();
+    tc_run(jobs, njobs, threads, &c);
+    secs = wall_seconds() - t0;
+    printf("  %-6s %2d thread%s %8.3f s %7.2f GB/s  (%lld identifiers, %d distinct)\n",
+           label, threads, threads == 1 ? " " : "s", secs, n / secs / 1e9, c.identifiers, c.idents.used);
+    tc_table_free(&c.idents);
+    free(jobs);
+}
+
+int main(int argc, char **argv)
+{
+    long long mb = argc > 1 ? atoll(argv[1]) : 256;
+    long long n = mb << 20;
+    int ncpu = cpu_count();
+    char *text = make_corpus(n);
+    FILE *f;
+
+    if (check_boundaries()) return 1;
+    printf("corpus: %lld MB, %d CPUs\n", mb, ncpu);
+    for (int t = 1; t <= ncpu; t *= 2) run("memory", text, NULL, n, t);
+    if (ncpu & (ncpu - 1)) run("memory", text, NULL, n, ncpu);
+
+    f = fopen(BENCH_FILE, "wb");
+    if (!f) {
+        perror("fopen");
+        return 1;
+    }
+    fwrite(text, 1, (size_t)n, f);
+    fclose(f);
+    free(text);
+    /* the first run warms the page cache */
+    run("file", NULL, BENCH_FILE, n, 1);
+    for (int t = 1; t <= ncpu; t *= 2) run("file", NULL, BENCH_FILE, n, t);
+    if (ncpu & (ncpu - 1)) run("file", NULL, BENCH_FILE, n, ncpu);
+    remove(BENCH_FILE);
+    return 0;
+}
@@ -0,0 +1,10 @@
+@echo off
+call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvarsall.bat" x64
+cl.exe "bench_dfa.c" /Febench_dfa.exe /O2 /W4 /std:c11
+cl.exe "bench_pipeline.c" /Febench_pipeline.exe /O2 /W4 /std:c11
+cl.exe "bench_tokencount.c" /Febench_tokencount.exe /O2 /W4 /std:c11
+cl.exe "bench_semantic.c" /Febench_semantic.exe /O2 /W4 /std:c11
+cl.exe "bench_input.c" /Febench_input.exe /O2 /W4 /std:c11
+cl.exe "bench_batchio.c" /Febench_batchio.exe /O2 /W4 /std:c11
+cl.exe "bench_sourcemap.c" /Febench_sourcemap.exe /O2 /W4 /std:c11
+cl.exe "bench_flow.c" /Febench_flow.exe /O2 /W4 /std:c11
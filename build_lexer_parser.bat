@@ -1,4 +1,6 @@
 @echo off
 call "C:\Program Files\Microsoft Visual Studio\2022\Community\VC\Auxiliary\Build\vcvarsall.bat" x64
+cl.exe "lexgen.c" /Felexgen.exe /W4 /std:c11
+lexgen.exe lexer_spec.txt lexer_tables.h
 cl.exe "project_lexer.c" /Feproject_lexer.exe /W4 /std:c11
 cl.exe "project_parser.c" /Feproject_parser.exe /W4 /std:c11
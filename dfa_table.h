@@ -0,0 +1,359 @@
+#ifndef DFA_TABLE_H
+#define DFA_TABLE_H
+/* dfa_table.h
+    Compact DFA transition tables (MSVC-compatible C, header only)
+
+    A DFA is handed over as a plain states x 256 table and packed into one
+    of three layouts:
+      DFA_DENSE8   8-bit premultiplied state offsets, one row per state
+      DFA_DENSE16  16-bit premultiplied state offsets, one row per state
+      DFA_COMB16   row-displacement (comb) packing for big sparse tables
+    Bytes are first folded into equivalence classes, so a row holds one
+    entry per class instead of one per byte.  States are renumbered so
+    that 0 is the dead state and every accepting state comes last, which
+    turns "is accepting" into a single compare.  Each accepting state also
+    keeps a small tag (e.g. a token kind) so one table can classify words.
+
+    Tables may also be emitted as static data by lexgen.c, which is why
+    the table pointers are const.  The functions are static inline, so a
+    file that only matches (the lexer, tokencount) does not warn about
+    the build-time ones it leaves unused.
+
+    Usage:
+        dfa_table d;
+        dfa_build(&d, nstates, trans, tags, start, DFA_AUTO);
+        n = dfa_match_len(&d, text, len);
+        dfa_free(&d);
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#define DFA_AUTO    -1
+#define DFA_DENSE8   0
+#define DFA_DENSE16  1
+#define DFA_COMB16   2
+
+/* dense rows bigger than this no longer sit comfortably in L1 */
+#define DFA_DENSE_LIMIT (32 * 1024)
+
+typedef struct {
+    int layout;
+    int nstates;                /* including the dead state 0 */
+    int nclasses;
+    int start;                  /* premultiplied for dense layouts */
+    int accept_min;             /* first accepting state (same scale as start) */
+    unsigned char classmap[256];
+    const unsigned char *t8;    /* DFA_DENSE8:  nstates * nclasses */
+    const unsigned short *t16;  /* DFA_DENSE16: nstates * nclasses */
+    const unsigned short *base; /* DFA_COMB16:  nstates */
+    const unsigned short *check;/* DFA_COMB16:  comb_len, owner state + 1 */
+    const unsigned short *next; /* DFA_COMB16:  comb_len */
+    int comb_len;
+    const unsigned char *tag;   /* nstates, 0 for non-accepting states */
+} dfa_table;
+
+static inline const char *dfa_layout_name(int layout)
+{
+    switch (layout) {
+    case DFA_DENSE8:  return "dense8";
+    case DFA_DENSE16: return "dense16";
+    case DFA_COMB16:  return "comb16";
+    }
+    return "?";
+}
+
+/* Bytes that every state sends to the same place share a class. */
+static inline int dfa_byte_classes(int nstates, const int *trans, unsigned char *classmap, int *rep)
+{
+    int b, c, s, nclasses, same;
+
+    nclasses = 0;
+    for (b = 0; b < 256; b++) {
+        for (c = 0; c < nclasses; c++) {
+            same = 1;
+            for (s = 0; s < nstates; s++) {
+                if (trans[s * 256 + b] != trans[s * 256 + rep[c]]) {
+                    same = 0;
+                    break;
+                }
+            }
+            if (same) break;
+        }
+        if (c == nclasses) rep[nclasses++] = b;
+        classmap[b] = (unsigned char)c;
+    }
+    return nclasses;
+}
+
+/* Pack rows with first-fit displacement; returns the comb length or -1. */
+static inline int dfa_pack_comb(dfa_table *d, const int *rows)
+{
+    int s, c, off, fits, len, cap, lo, first;
+    unsigned short *check, *next, *base;
+
+    if (d->nstates <= 0) return -1;
+    cap = d->nstates + d->nclasses + 1;
+    if (cap < 256) cap = 256;
+    check = (unsigned short *)calloc((size_t)cap, sizeof(unsigned short));
+    next = (unsigned short *)calloc((size_t)cap, sizeof(unsigned short));
+    base = (unsigned short *)calloc((size_t)d->nstates, sizeof(unsigned short));
+    if (!check || !next || !base) goto fail;
+
+    len = 0;
+    lo = 0;     /* no free slot below this index */
+    for (s = 0; s < d->nstates; s++) {
+        first = 0;
+        while (first < d->nclasses && rows[s * d->nclasses + first] == 0) first++;
+        if (first == d->nclasses) first = 0;
+        for (off = lo > first ? lo - first : 0;; off++) {
+            if (off + d->nclasses > 65535) goto fail;
+            if (off + d->nclasses > cap) {
+                int ncap = cap * 2;
+                unsigned short *nc = (unsigned short *)realloc(check, ncap * sizeof(unsigned short));
+                unsigned short *nn;
+                if (!nc) goto fail;
+                check = nc;
+                nn = (unsigned short *)realloc(next, ncap * sizeof(unsigned short));
+                if (!nn) goto fail;
+                next = nn;
+                memset(check + cap, 0, (ncap - cap) * sizeof(unsigned short));
+                memset(next + cap, 0, (ncap - cap) * sizeof(unsigned short));
+                cap = ncap;
+            }
+            fits = 1;
+            for (c = 0; c < d->nclasses; c++) {
+                if (rows[s * d->nclasses + c] != 0 && check[off + c] != 0) {
+                    fits = 0;
+                    break;
+                }
+            }
+            if (fits) break;
+        }
+        base[s] = (unsigned short)off;
+        for (c = 0; c < d->nclasses; c++) {
+            if (rows[s * d->nclasses + c] != 0) {
+                check[off + c] = (unsigned short)(s + 1);
+                next[off + c] = (unsigned short)rows[s * d->nclasses + c];
+            }
+        }
+        /* every lookup base[s] + class must land inside the arrays */
+        if (off + d->nclasses > len) len = off + d->nclasses;
+        while (lo < cap && check[lo] != 0) lo++;
+    }
+    d->comb_len = len;
+    d->base = base;
+    d->check = check;
+    d->next = next;
+    return d->comb_len;
+
+fail:
+    free(check);
+    free(next);
+    free(base);
+    return -1;
+}
+
+static inline int dfa_pick_layout(int nstates, int nclasses, int live)
+{
+    long cells;
+
+    cells = (long)nstates * nclasses;
+    if (cells <= 256) return DFA_DENSE8;
+    if (cells > 65536) return DFA_COMB16;
+    if (cells * 2 <= DFA_DENSE_LIMIT || live * 4 > cells) return DFA_DENSE16;
+    return DFA_COMB16;
+}
+
+/* trans: nstates * 256 entries, -1 means "no transition".
+   tags:  nstates entries, nonzero marks an accepting state.
+   Returns 0 on success, -1 if the table does not fit the requested layout. */
+static inline int dfa_build(dfa_table *d, int nstates, const int *trans,
+                            const unsigned char *tags, int start, int layout)
+{
+    int *renum, *rows, *full, *rep;
+    unsigned char *t8, *tag;
+    unsigned short *t16;
+    int s, c, id, live, mult, rc;
+
+    memset(d, 0, sizeof(*d));
+    d->nstates = nstates + 1;
+    rc = -1;
+
+    renum = (int *)malloc(nstates * sizeof(int));
+    full = (int *)malloc(d->nstates * 256 * sizeof(int));
+    rep = (int *)malloc(256 * sizeof(int));
+    tag = (unsigned char *)calloc(d->nstates, 1);
+    rows = NULL;
+    if (!renum || !full || !rep || !tag) goto done;
+
+    /* dead state first, then non-accepting states, then accepting ones */
+    id = 1;
+    for (s = 0; s < nstates; s++)
+        if (!tags[s]) renum[s] = id++;
+    d->accept_min = id;
+    for (s = 0; s < nstates; s++) {
+        if (tags[s]) {
+            tag[id] = tags[s];
+            renum[s] = id++;
+        }
+    }
+    d->tag = tag;
+    tag = NULL;
+
+    for (c = 0; c < 256; c++) full[c] = 0;
+    for (s = 0; s < nstates; s++)
+        for (c = 0; c < 256; c++)
+            full[renum[s] * 256 + c] = trans[s * 256 + c] < 0 ? 0 : renum[trans[s * 256 + c]];
+
+    d->nclasses = dfa_byte_classes(d->nstates, full, d->classmap, rep);
+    rows = (int *)malloc(d->nstates * d->nclasses * sizeof(int));
+    if (!rows) goto done;
+    live = 0;
+    for (s = 0; s < d->nstates; s++) {
+        for (c = 0; c < d->nclasses; c++) {
+            rows[s * d->nclasses + c] = full[s * 256 + rep[c]];
+            if (rows[s * d->nclasses + c] != 0) live++;
+        }
+    }
+
+    if (layout == DFA_AUTO)
+        layout = dfa_pick_layout(d->nstates, d->nclasses, live);
+    d->layout = layout;
+
+    if (layout == DFA_DENSE8 || layout == DFA_DENSE16) {
+        long cells = (long)d->nstates * d->nclasses;
+        if (cells > (layout == DFA_DENSE8 ? 256L : 65536L)) goto done;
+        mult = d->nclasses;
+        if (layout == DFA_DENSE8) {
+            t8 = (unsigned char *)malloc(cells);
+            if (!t8) goto done;
+            for (s = 0; s < cells; s++) t8[s] = (unsigned char)(rows[s] * mult);
+            d->t8 = t8;
+        } else {
+            t16 = (unsigned short *)malloc(cells * sizeof(unsigned short));
+            if (!t16) goto done;
+            for (s = 0; s < cells; s++) t16[s] = (unsigned short)(rows[s] * mult);
+            d->t16 = t16;
+        }
+        d->start = renum[start] * mult;
+        d->accept_min *= mult;
+    } else {
+        if (d->nstates > 65535 || dfa_pack_comb(d, rows) < 0) goto done;
+        d->start = renum[start];
+    }
+    rc = 0;
+
+done:
+    free(renum);
+    free(full);
+    free(rep);
+    free(rows);
+    free(tag);
+    if (rc != 0) {
+        free((void *)d->tag);
+        d->tag = NULL;
+    }
+    return rc;
+}
+
+/* Only for tables made by dfa_build, never for generated static ones. */
+static inline void dfa_free(dfa_table *d)
+{
+    free((void *)d->t8);
+    free((void *)d->t16);
+    free((void *)d->base);
+    free((void *)d->check);
+    free((void *)d->next);
+    free((void *)d->tag);
+    memset(d, 0, sizeof(*d));
+}
+
+static inline long dfa_table_bytes(const dfa_table *d)
+{
+    long n = 256 + d->nstates;  /* classmap, tags */
+    switch (d->layout) {
+    case DFA_DENSE8:  n += (long)d->nstates * d->nclasses; break;
+    case DFA_DENSE16: n += (long)d->nstates * d->nclasses * 2; break;
+    case DFA_COMB16:  n += (long)d->nstates * 2 + (long)d->comb_len * 4; break;
+    }
+    return n;
+}
+
+static inline int dfa_comb_step(const dfa_table *d, int s, int c)
+{
+    int i = d->base[s] + c;
+    return d->check[i] == s + 1 ? d->next[i] : 0;
+}
+
+/* Length of the longest prefix of s[0..n) the DFA accepts, or -1. */
+static inline int dfa_match_len(const dfa_table *d, const char *s, int n)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *cm = d->classmap;
+    int st, i, last;
+
+    st = d->start;
+    last = st >= d->accept_min ? 0 : -1;
+    switch (d->layout) {
+    case DFA_DENSE8:
+        for (i = 0; i < n; i++) {
+            st = d->t8[st + cm[p[i]]];
+            if (st == 0) break;
+            if (st >= d->accept_min) last = i + 1;
+        }
+        break;
+    case DFA_DENSE16:
+        for (i = 0; i < n; i++) {
+            st = d->t16[st + cm[p[i]]];
+            if (st == 0) break;
+            if (st >= d->accept_min) last = i + 1;
+        }
+        break;
+    default:
+        for (i = 0; i < n; i++) {
+            st = dfa_comb_step(d, st, cm[p[i]]);
+            if (st == 0) break;
+            if (st >= d->accept_min) last = i + 1;
+        }
+        break;
+    }
+    return last;
+}
+
+/* State reached after all of s[0..n), 0 once the DFA has died. */
+static inline int dfa_run(const dfa_table *d, const char *s, int n)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *cm = d->classmap;
+    int st, i;
+
+    st = d->start;
+    switch (d->layout) {
+    case DFA_DENSE8:
+        for (i = 0; i < n && st != 0; i++) st = d->t8[st + cm[p[i]]];
+        break;
+    case DFA_DENSE16:
+        for (i = 0; i < n && st != 0; i++) st = d->t16[st + cm[p[i]]];
+        break;
+    default:
+        for (i = 0; i < n && st != 0; i++) st = dfa_comb_step(d, st, cm[p[i]]);
+        break;
+    }
+    return st;
+}
+
+/* 1 if the whole of s[0..n) is accepted. */
+static inline int dfa_accepts(const dfa_table *d, const char *s, int n)
+{
+    return dfa_run(d, s, n) >= d->accept_min;
+}
+
+/* Tag of the accepting state reached by all of s[0..n), or 0. */
+static inline int dfa_classify(const dfa_table *d, const char *s, int n)
+{
+    int st = dfa_run(d, s, n);
+    if (st < d->accept_min) return 0;
+    return d->tag[d->layout == DFA_COMB16 ? st : st / d->nclasses];
+}
+
+#endif /* DFA_TABLE_H */
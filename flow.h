@@ -0,0 +1,933 @@
+#ifndef FLOW_H
+#define FLOW_H
+/* flow.h
+   Control-flow graph and dataflow checks, one function at a time, fed
+   by the semantic pass (semantic.h) with the tokens of each function
+   body and the variable reads and writes it has resolved.
+
+   A push-down statement parser turns { }, if/else, while, for, do,
+   switch/case, break, continue, return and loop_xx01: labels into basic
+   blocks and edges as the tokens arrive, so no token is kept.  Inside a
+   block only what the dataflow needs is recorded: the first read of
+   each variable that comes before any write (upward exposed), and the
+   last write.  When the function's closing brace arrives the graph is
+   checked:
+   - reachability from the entry block: statements nothing reaches
+   - reaching definitions (forward): a read that the "declared, never
+     assigned" definition of its variable can reach
+   - liveness (backward): a value stored by an assignment or an
+     initializer that no path reads
+   and break/continue are matched against the enclosing loops, and
+   labels against the breaks that name them.  The two dataflow problems
+   are solved over bitsets with a worklist, but only over the variables
+   that have something to check, and 64 * w of them at a time (a slice):
+   each block holds w words of facts and w of kill bits, cleared when the
+   slice first reaches it, with w shrunk so that the sets of a large
+   function stay within FL_SLICE_BYTES.  A slice costs the blocks its
+   variables' values flow through, a few sweeps over them, times w.  The
+   worst case is values that cross the whole function: then every slice
+   visits every block, blocks * variables / (64 * w) visits in all.
+
+   Problems found are queued in fl->find as (kind, position, name) and
+   the caller turns them into messages.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "memprof.h"
+#include "source_map.h"
+
+// token classes, as the semantic pass sorts them
+enum {
+    FL_T_OTHER, FL_T_IDENT, FL_T_LABEL, FL_T_LBRACE, FL_T_RBRACE, FL_T_LPAREN, FL_T_RPAREN,
+    FL_T_TERM, FL_T_COMMA, FL_T_COLON, FL_T_IF, FL_T_ELSE, FL_T_WHILE, FL_T_FOR, FL_T_DO,
+    FL_T_SWITCH, FL_T_CASE, FL_T_DEFAULT, FL_T_BREAK, FL_T_CONTINUE, FL_T_RETURN
+};
+
+// findings
+enum {
+    FL_F_BREAK_OUTSIDE, FL_F_CONTINUE_OUTSIDE, FL_F_BREAK_NOT_ENCLOSING, FL_F_BREAK_NO_LABEL,
+    FL_F_LABEL_UNUSED, FL_F_UNREACHABLE, FL_F_UNASSIGNED, FL_F_DEAD_STORE
+};
+
+// kinds of definition; FL_K_COND: declared in a condition, "while (dec
+// _i1a < 3..)", and set there as far as the checks go
+enum { FL_K_UNDEF, FL_K_INIT, FL_K_ASSIGN, FL_K_COND };
+enum { FL_FUNC, FL_BLOCK, FL_IF, FL_LOOP, FL_DO, FL_SWITCH };
+enum { FL_S_COND, FL_S_BODY, FL_S_ELSE_WAIT, FL_S_ELSE, FL_S_DO_WHILE, FL_S_DO_END };
+
+#define FL_ENTRY 0
+#define FL_EXIT 1
+
+// the dataflow problems are solved for up to 64 * FL_SLICE_WORDS
+// variables at a time, narrower when the function's blocks would need
+// more than FL_SLICE_BYTES of sets
+#define FL_SLICE_WORDS 16
+#define FL_SLICE_BYTES (1 << 20)
+
+typedef struct {
+    sm_pos first;                   // first statement in the block, SM_NONE if none
+} fl_block;
+
+typedef struct {
+    int from, to;
+} fl_edge;
+
+typedef struct {
+    int var, block, kind;
+    int used;                       // read later in its own block
+    int next;                       // next definition of the same variable
+    sm_pos pos;
+} fl_def;
+
+typedef struct {
+    int var, block;
+    int next;                       // next read of the same variable
+    sm_pos pos;
+} fl_use;
+
+typedef struct {
+    int name;                       // caller's name id
+    int first_def;                  // chain through fl_def.next
+    int first_use;                  // chain through fl_use.next
+    int decl_def;                   // definition made by the declaration
+    int escaped;                    // address taken: no checks
+    int reported;
+    int stamp;                      // block the fields below describe
+    int blk_def;                    // its definition of this variable, or -1
+    int blk_exposed;                // read before any write in the block
+} fl_var;
+
+typedef struct {
+    int kind, state;
+    int paren;                      // paren depth the condition starts at
+    int cond;                       // IF: block ending in the test; SWITCH: the dispatch block
+    int then_end;                   // IF: block ending the then part
+    int head, body, exit;           // loops: continue target, first body block, break target
+    int label;                      // loop label, or -1
+    int has_default;
+} fl_frame;
+
+typedef struct {
+    int name;
+    sm_pos pos;
+    int targeted;
+} fl_label;
+
+typedef struct {
+    int kind, name;
+    sm_pos pos;
+} fl_finding;
+
+typedef struct {
+    int active;                     // inside a function body
+    fl_block *blk;
+    int nblk, blk_cap;
+    fl_edge *edge;
+    int nedge, edge_cap;
+    fl_def *def;
+    int ndef, def_cap;
+    fl_use *use;
+    int nuse, use_cap;
+    fl_var *var;
+    int nvar, var_cap;
+    fl_frame *fr;
+    int nfr, fr_cap;
+    fl_label *label;
+    int nlabel, label_cap;
+    fl_finding *find;
+    int nfind, find_cap;
+
+    int cur;                        // block statements go into
+    int paren;
+    int stmt_start;                 // the next token starts a statement
+    int pending_label;              // label waiting for its loop, or -1
+    int skip_colon;                 // the ':' of a label
+    int case_label;                 // between case/default and its ':'
+    int jump;                       // FL_T_BREAK / CONTINUE / RETURN until the terminator
+    int jump_label;
+    sm_pos jump_pos;
+    int assign_var, assign_paren;   // write that lands when its expression ends
+    sm_pos assign_pos;
+
+    // solver scratch, reused from function to function
+    int *succ_off, *succ, *pred_off, *pred, *queue;
+    int *order, *post;              // reachable blocks in postorder, and each one's place there
+    int nreach;
+    unsigned char *mark;
+    int scratch_cap, edge_scratch_cap;
+    int *slice_of;                  // slice whose sets the block holds
+    int slice, ndirty;
+    uint64_t *dirty;                // blocks to revisit, by place in the sweep order
+    uint64_t *sets;                 // per-block sets of the current slice
+    size_t sets_cap;
+    int *cand;                      // variables the problem being solved checks
+    int cand_cap;
+    long blocks_total;              // blocks over every function so far
+} fl_state;
+
+static inline void *fl_resize(void *p, size_t bytes){
+    p = mp_realloc(MP_PARSER, p, bytes);
+    if(!p){ fprintf(stderr, "flow: out of memory\n"); exit(1); }
+    return p;
+}
+
+static inline void *fl_grow(void *p, int *cap, int need, size_t size){
+    if(need <= *cap) return p;
+    int ncap = *cap ? *cap : 64;
+    while(ncap < need) ncap *= 2;
+    *cap = ncap;
+    return fl_resize(p, (size_t)ncap * size);
+}
+
+static inline void fl_init(fl_state *fl){
+    memset(fl, 0, sizeof(*fl));
+}
+
+static inline void fl_free(fl_state *fl){
+    mp_free(fl->blk); mp_free(fl->edge); mp_free(fl->def); mp_free(fl->use);
+    mp_free(fl->var); mp_free(fl->fr); mp_free(fl->label); mp_free(fl->find);
+    mp_free(fl->succ_off); mp_free(fl->succ); mp_free(fl->pred_off); mp_free(fl->pred);
+    mp_free(fl->queue); mp_free(fl->order); mp_free(fl->post);
+    mp_free(fl->mark); mp_free(fl->slice_of); mp_free(fl->dirty); mp_free(fl->sets); mp_free(fl->cand);
+    memset(fl, 0, sizeof(*fl));
+}
+
+static inline void fl_report(fl_state *fl, int kind, sm_pos pos, int name){
+    fl->find = (fl_finding *)fl_grow(fl->find, &fl->find_cap, fl->nfind + 1, sizeof(fl_finding));
+    fl->find[fl->nfind].kind = kind;
+    fl->find[fl->nfind].pos = pos;
+    fl->find[fl->nfind].name = name;
+    fl->nfind++;
+}
+
+static inline int fl_new_block(fl_state *fl){
+    fl->blk = (fl_block *)fl_grow(fl->blk, &fl->blk_cap, fl->nblk + 1, sizeof(fl_block));
+    fl->blk[fl->nblk].first = SM_NONE;
+    return fl->nblk++;
+}
+
+static inline void fl_edge_to(fl_state *fl, int from, int to){
+    fl->edge = (fl_edge *)fl_grow(fl->edge, &fl->edge_cap, fl->nedge + 1, sizeof(fl_edge));
+    fl->edge[fl->nedge].from = from;
+    fl->edge[fl->nedge].to = to;
+    fl->nedge++;
+}
+
+static inline fl_frame *fl_push(fl_state *fl, int kind, int state){
+    fl->fr = (fl_frame *)fl_grow(fl->fr, &fl->fr_cap, fl->nfr + 1, sizeof(fl_frame));
+    fl_frame *f = &fl->fr[fl->nfr++];
+    memset(f, 0, sizeof(*f));
+    f->kind = kind;
+    f->state = state;
+    f->paren = fl->paren;
+    f->label = -1;
+    return f;
+}
+
+static inline fl_var *fl_touch(fl_state *fl, int v){
+    fl_var *x = &fl->var[v];
+    if(x->stamp != fl->cur){
+        x->stamp = fl->cur;
+        x->blk_def = -1;
+        x->blk_exposed = 0;
+    }
+    return x;
+}
+
+static inline void fl_define(fl_state *fl, int v, sm_pos pos, int kind){
+    if(v < 0) return;
+    fl_var *x = fl_touch(fl, v);
+    if(x->blk_def >= 0){
+        fl_def *d = &fl->def[x->blk_def];
+        // overwritten in the same block before anything read it
+        if((d->kind == FL_K_ASSIGN || d->kind == FL_K_INIT) && !d->used && !x->escaped) fl_report(fl, FL_F_DEAD_STORE, d->pos, x->name);
+        d->kind = kind;
+        d->pos = pos;
+        d->used = 0;
+    } else {
+        fl->def = (fl_def *)fl_grow(fl->def, &fl->def_cap, fl->ndef + 1, sizeof(fl_def));
+        fl_def *d = &fl->def[fl->ndef];
+        d->var = v;
+        d->block = fl->cur;
+        d->kind = kind;
+        d->pos = pos;
+        d->used = 0;
+        d->next = x->first_def;
+        x->first_def = fl->ndef;
+        x->blk_def = fl->ndef++;
+    }
+}
+
+static inline void fl_flush_assign(fl_state *fl){
+    if(fl->assign_var < 0) return;
+    int v = fl->assign_var;
+    fl->assign_var = -1;
+    fl_define(fl, v, fl->assign_pos, FL_K_ASSIGN);
+}
+
+// ---- variable events from the semantic pass ----
+
+// a variable declared in the function body; returns its id, -1 outside functions
+static inline int fl_decl(fl_state *fl, int name, sm_pos pos, int has_init){
+    if(!fl->active) return -1;
+    fl->var = (fl_var *)fl_grow(fl->var, &fl->var_cap, fl->nvar + 1, sizeof(fl_var));
+    int v = fl->nvar++;
+    fl_var *x = &fl->var[v];
+    memset(x, 0, sizeof(*x));
+    x->name = name;
+    x->first_def = -1;
+    x->first_use = -1;
+    x->stamp = -1;
+    fl_define(fl, v, pos, has_init ? FL_K_INIT : fl->paren > 0 ? FL_K_COND : FL_K_UNDEF);
+    x->decl_def = x->blk_def;
+    return v;
+}
+
+static inline void fl_read(fl_state *fl, int v, sm_pos pos){
+    if(v < 0 || !fl->active) return;
+    fl_var *x = fl_touch(fl, v);
+    if(x->blk_def >= 0){
+        if(fl->def[x->blk_def].kind == FL_K_UNDEF && !x->escaped && !x->reported){
+            x->reported = 1;
+            fl_report(fl, FL_F_UNASSIGNED, pos, x->name);
+        }
+        fl->def[x->blk_def].used = 1;
+    } else if(!x->blk_exposed){
+        x->blk_exposed = 1;
+        fl->use = (fl_use *)fl_grow(fl->use, &fl->use_cap, fl->nuse + 1, sizeof(fl_use));
+        fl->use[fl->nuse].var = v;
+        fl->use[fl->nuse].block = fl->cur;
+        fl->use[fl->nuse].pos = pos;
+        fl->use[fl->nuse].next = x->first_use;
+        x->first_use = fl->nuse++;
+    }
+}
+
+// "_x = ...": the write lands after the right-hand side
+static inline void fl_assign(fl_state *fl, int v, sm_pos pos){
+    if(v < 0 || !fl->active) return;
+    fl_flush_assign(fl);
+    fl->assign_var = v;
+    fl->assign_pos = pos;
+    fl->assign_paren = fl->paren;
+}
+
+// "_x++", "_x += 2": read, then written
+static inline void fl_update(fl_state *fl, int v, sm_pos pos){
+    if(v < 0 || !fl->active) return;
+    fl_read(fl, v, pos);
+    fl_define(fl, v, pos, FL_K_ASSIGN);
+}
+
+// "&_x": anything may write or read it from here on
+static inline void fl_escape(fl_state *fl, int v){
+    if(v >= 0 && fl->active) fl->var[v].escaped = 1;
+}
+
+// ---- statements ----
+
+static inline void fl_begin_function(fl_state *fl){
+    fl->active = 1;
+    fl->nblk = fl->nedge = fl->ndef = fl->nuse = fl->nvar = fl->nfr = fl->nlabel = 0;
+    fl_new_block(fl);               // FL_ENTRY
+    fl_new_block(fl);               // FL_EXIT
+    fl->cur = FL_ENTRY;
+    fl->paren = 0;
+    fl->stmt_start = 1;
+    fl->pending_label = -1;
+    fl->skip_colon = fl->case_label = 0;
+    fl->jump = 0;
+    fl->assign_var = -1;
+    fl_push(fl, FL_FUNC, FL_S_BODY);
+}
+
+// closes the top frame as it stands, joining its blocks into fl->cur
+static inline void fl_close_top(fl_state *fl){
+    fl_frame *f = &fl->fr[fl->nfr - 1];
+    int j;
+    switch(f->kind){
+    case FL_IF:
+        if(f->state == FL_S_COND) break;
+        if(f->state == FL_S_BODY) f->then_end = fl->cur;
+        j = fl_new_block(fl);
+        fl_edge_to(fl, f->then_end, j);
+        fl_edge_to(fl, f->state == FL_S_ELSE ? fl->cur : f->cond, j);
+        fl->cur = j;
+        break;
+    case FL_LOOP:
+        fl_edge_to(fl, fl->cur, f->state == FL_S_COND ? f->exit : f->head);
+        fl->cur = f->exit;
+        break;
+    case FL_DO:
+        if(f->state == FL_S_BODY){
+            fl_edge_to(fl, fl->cur, f->head);
+            fl->cur = f->head;
+        }
+        if(f->state == FL_S_DO_END) fl_edge_to(fl, fl->cur, f->body);
+        fl_edge_to(fl, fl->cur, f->exit);
+        fl->cur = f->exit;
+        break;
+    case FL_SWITCH:
+        if(f->state == FL_S_COND) break;
+        fl_edge_to(fl, fl->cur, f->exit);
+        if(!f->has_default) fl_edge_to(fl, f->cond, f->exit);
+        fl->cur = f->exit;
+        break;
+    }
+    fl->nfr--;
+}
+
+// a statement just ended: finish the constructs it completes
+static inline void fl_stmt_done(fl_state *fl){
+    fl->stmt_start = 1;
+    for(;;){
+        fl_frame *f = &fl->fr[fl->nfr - 1];
+        if(f->kind == FL_FUNC || f->kind == FL_BLOCK) return;
+        if(f->kind == FL_IF && f->state == FL_S_BODY){
+            f->then_end = fl->cur;
+            f->state = FL_S_ELSE_WAIT;      // settled by the next token
+            return;
+        }
+        if(f->kind == FL_DO && f->state == FL_S_BODY){
+            fl_edge_to(fl, fl->cur, f->head);
+            fl->cur = f->head;
+            f->state = FL_S_DO_WHILE;
+            return;
+        }
+        if(f->state != FL_S_BODY && f->state != FL_S_ELSE) return;
+        fl_close_top(fl);
+    }
+}
+
+static inline void fl_cond_done(fl_state *fl, fl_frame *f){
+    int b;
+    switch(f->kind){
+    case FL_IF:
+        f->cond = fl->cur;
+        b = fl_new_block(fl);
+        fl_edge_to(fl, fl->cur, b);
+        fl->cur = b;
+        f->state = FL_S_BODY;
+        break;
+    case FL_LOOP:
+        if(f->head < 0) f->head = fl->cur;  // "for (x)" with no ';'
+        f->body = fl_new_block(fl);
+        fl_edge_to(fl, fl->cur, f->body);
+        fl_edge_to(fl, fl->cur, f->exit);
+        fl->cur = f->body;
+        f->state = FL_S_BODY;
+        break;
+    case FL_SWITCH:
+        f->cond = fl->cur;
+        fl->cur = fl_new_block(fl);     // code before the first case runs never
+        f->state = FL_S_BODY;
+        break;
+    case FL_DO:
+        f->state = FL_S_DO_END;
+        return;
+    }
+    fl->stmt_start = 1;
+}
+
+static inline fl_frame *fl_loop_frame(fl_state *fl, int kind){
+    fl_frame *f = fl_push(fl, kind, FL_S_COND);
+    f->label = fl->pending_label;
+    fl->pending_label = -1;
+    f->exit = fl_new_block(fl);
+    return f;
+}
+
+static inline void fl_jump(fl_state *fl){
+    int i, target = -1, kind = fl->jump;
+    fl->jump = 0;
+    if(kind == FL_T_RETURN){
+        fl_edge_to(fl, fl->cur, FL_EXIT);
+    } else {
+        for(i = fl->nfr - 1; i > 0 && target < 0; i--){
+            fl_frame *f = &fl->fr[i];
+            if(f->kind != FL_LOOP && f->kind != FL_DO && f->kind != FL_SWITCH) continue;
+            if(kind == FL_T_CONTINUE && f->kind == FL_SWITCH) continue;
+            if(kind == FL_T_BREAK && fl->jump_label >= 0 &&
+               (f->label < 0 || fl->label[f->label].name != fl->jump_label)) continue;
+            target = i;
+        }
+        if(kind == FL_T_BREAK && fl->jump_label >= 0){
+            int known = 0;
+            for(i = 0; i < fl->nlabel; i++)
+                if(fl->label[i].name == fl->jump_label){ fl->label[i].targeted = 1; known = 1; }
+            if(target < 0) fl_report(fl, known ? FL_F_BREAK_NOT_ENCLOSING : FL_F_BREAK_NO_LABEL, fl->jump_pos, fl->jump_label);
+        } else if(target < 0){
+            fl_report(fl, kind == FL_T_BREAK ? FL_F_BREAK_OUTSIDE : FL_F_CONTINUE_OUTSIDE, fl->jump_pos, -1);
+        }
+        if(target < 0) return;          // reported; the code after it is not made unreachable too
+        fl_edge_to(fl, fl->cur, kind == FL_T_BREAK ? fl->fr[target].exit : fl->fr[target].head);
+    }
+    fl->cur = fl_new_block(fl);         // whatever follows is reached by a label or not at all
+}
+
+static inline void fl_analyze(fl_state *fl);
+
+static inline void fl_end_function(fl_state *fl){
+    fl_flush_assign(fl);
+    while(fl->nfr > 1) fl_close_top(fl);
+    fl->nfr = 0;
+    fl_edge_to(fl, fl->cur, FL_EXIT);
+    fl_analyze(fl);
+    fl->blocks_total += fl->nblk;
+    fl->active = 0;
+}
+
+// feeds one token of a function body; name is the caller's id for
+// identifiers and labels, -1 otherwise.  Returns 1 when the token closed
+// the function (its findings are then queued).
+static inline int fl_token(fl_state *fl, int cls, int name, sm_pos pos){
+    fl_frame *f;
+    if(!fl->active) return 0;
+
+    // an if whose then part is done has an else or has ended
+    while(fl->fr[fl->nfr - 1].kind == FL_IF && fl->fr[fl->nfr - 1].state == FL_S_ELSE_WAIT && cls != FL_T_ELSE){
+        fl_close_top(fl);
+        fl_stmt_done(fl);
+    }
+    if(cls == FL_T_COLON && fl->skip_colon){ fl->skip_colon = 0; return 0; }
+
+    f = &fl->fr[fl->nfr - 1];
+    if(fl->stmt_start && cls != FL_T_LBRACE && cls != FL_T_RBRACE && cls != FL_T_ELSE && cls != FL_T_CASE &&
+       cls != FL_T_DEFAULT && cls != FL_T_LABEL && cls != FL_T_TERM && cls != FL_T_COLON){
+        fl->stmt_start = 0;
+        // the "while" of do ... while is not a statement of its own
+        if(fl->blk[fl->cur].first == SM_NONE && !(f->kind == FL_DO && f->state == FL_S_DO_WHILE)) fl->blk[fl->cur].first = pos;
+        if(cls != FL_T_WHILE && cls != FL_T_FOR && cls != FL_T_DO) fl->pending_label = -1;
+    }
+
+    switch(cls){
+    case FL_T_LPAREN:
+        fl->paren++;
+        break;
+    case FL_T_RPAREN:
+        if(fl->paren > 0) fl->paren--;
+        if(fl->assign_var >= 0 && fl->paren < fl->assign_paren) fl_flush_assign(fl);
+        if((f->state == FL_S_COND || f->state == FL_S_DO_WHILE) && fl->paren == f->paren && f->kind != FL_FUNC) fl_cond_done(fl, f);
+        break;
+    case FL_T_COMMA:
+        if(fl->paren == 0 || fl->paren < fl->assign_paren) fl_flush_assign(fl);
+        break;
+    case FL_T_TERM:
+        fl_flush_assign(fl);
+        if(fl->paren > 0){                  // inside a for header
+            if(f->kind == FL_LOOP && f->head < 0){
+                f->head = fl_new_block(fl);
+                fl_edge_to(fl, fl->cur, f->head);
+                fl->cur = f->head;
+            }
+            break;
+        }
+        if(fl->jump) fl_jump(fl);
+        if(f->kind == FL_DO && f->state == FL_S_DO_END){
+            fl_edge_to(fl, fl->cur, f->body);
+            fl_edge_to(fl, fl->cur, f->exit);
+            fl->cur = f->exit;
+            fl->nfr--;
+        }
+        fl_stmt_done(fl);
+        break;
+    case FL_T_LBRACE:
+        fl_flush_assign(fl);
+        fl_push(fl, FL_BLOCK, FL_S_BODY);
+        fl->stmt_start = 1;
+        break;
+    case FL_T_RBRACE:
+        fl_flush_assign(fl);
+        if(fl->jump) fl_jump(fl);
+        fl->paren = 0;
+        while(fl->fr[fl->nfr - 1].kind != FL_BLOCK && fl->fr[fl->nfr - 1].kind != FL_FUNC) fl_close_top(fl);
+        if(fl->fr[fl->nfr - 1].kind == FL_FUNC){
+            fl_end_function(fl);
+            return 1;
+        }
+        fl->nfr--;
+        fl_stmt_done(fl);
+        break;
+    case FL_T_IF:
+        fl_push(fl, FL_IF, FL_S_COND);
+        break;
+    case FL_T_ELSE:
+        if(f->kind == FL_IF && f->state == FL_S_ELSE_WAIT){
+            int e = fl_new_block(fl);
+            fl_edge_to(fl, f->cond, e);
+            fl->cur = e;
+            f->state = FL_S_ELSE;
+            fl->stmt_start = 1;
+        }
+        break;
+    case FL_T_WHILE:
+        if(f->kind == FL_DO && f->state == FL_S_DO_WHILE){
+            f->paren = fl->paren;           // the condition of do ... while
+            break;
+        }
+        f = fl_loop_frame(fl, FL_LOOP);
+        f->head = fl_new_block(fl);
+        fl_edge_to(fl, fl->cur, f->head);
+        fl->cur = f->head;
+        break;
+    case FL_T_FOR:
+        // the head starts after the init clause, which runs once
+        f = fl_loop_frame(fl, FL_LOOP);
+        f->head = -1;
+        break;
+    case FL_T_DO:
+        f = fl_loop_frame(fl, FL_DO);
+        f->state = FL_S_BODY;
+        f->body = fl_new_block(fl);
+        f->head = fl_new_block(fl);         // the condition, where continue goes
+        fl_edge_to(fl, fl->cur, f->body);
+        fl->cur = f->body;
+        fl->stmt_start = 1;
+        break;
+    case FL_T_SWITCH:
+        f = fl_push(fl, FL_SWITCH, FL_S_COND);
+        f->exit = fl_new_block(fl);
+        break;
+    case FL_T_CASE:
+    case FL_T_DEFAULT: {
+        int i = fl->nfr - 1;
+        while(i > 0 && fl->fr[i].kind != FL_SWITCH) i--;
+        if(i == 0) break;
+        int b = fl_new_block(fl);
+        fl_edge_to(fl, fl->fr[i].cond, b);
+        fl_edge_to(fl, fl->cur, b);         // falls through from the case above
+        fl->cur = b;
+        if(cls == FL_T_DEFAULT) fl->fr[i].has_default = 1;
+        fl->case_label = 1;
+        break;
+    }
+    case FL_T_COLON:
+        if(fl->case_label){
+            fl->case_label = 0;
+            fl->stmt_start = 1;
+        }
+        break;
+    case FL_T_LABEL:
+        fl->label = (fl_label *)fl_grow(fl->label, &fl->label_cap, fl->nlabel + 1, sizeof(fl_label));
+        fl->label[fl->nlabel].name = name;
+        fl->label[fl->nlabel].pos = pos;
+        fl->label[fl->nlabel].targeted = 0;
+        fl->pending_label = fl->nlabel++;
+        fl->skip_colon = 1;
+        fl->stmt_start = 1;
+        break;
+    case FL_T_BREAK:
+    case FL_T_CONTINUE:
+    case FL_T_RETURN:
+        fl->jump = cls;
+        fl->jump_label = -1;
+        fl->jump_pos = pos;
+        break;
+    case FL_T_IDENT:
+        if(fl->jump == FL_T_BREAK && fl->jump_label < 0) fl->jump_label = name;
+        break;
+    }
+    return 0;
+}
+
+// ---- solver ----
+
+// room for need entries: the next power of two, as fl_grow
+static inline int fl_scratch_cap(int cap, int need){
+    if(need <= cap) return cap;
+    if(!cap) cap = 64;
+    while(cap < need) cap *= 2;
+    return cap;
+}
+
+// successor and predecessor lists in CSR form, and the blocks reachable
+// from the entry (mark 1) in postorder
+static inline void fl_build_graph(fl_state *fl){
+    int nb = fl->nblk, i, sp, cap;
+    if(nb + 1 > fl->scratch_cap){
+        cap = fl->scratch_cap = fl_scratch_cap(fl->scratch_cap, nb + 1);
+        fl->succ_off = (int *)fl_resize(fl->succ_off, cap * sizeof(int));
+        fl->pred_off = (int *)fl_resize(fl->pred_off, cap * sizeof(int));
+        fl->queue = (int *)fl_resize(fl->queue, cap * sizeof(int));
+        fl->order = (int *)fl_resize(fl->order, cap * sizeof(int));
+        fl->post = (int *)fl_resize(fl->post, cap * sizeof(int));
+        fl->mark = (unsigned char *)fl_resize(fl->mark, cap);
+        fl->slice_of = (int *)fl_resize(fl->slice_of, cap * sizeof(int));
+        fl->dirty = (uint64_t *)fl_resize(fl->dirty, (cap + 63) / 64 * sizeof(uint64_t));
+    }
+    if(fl->nedge > fl->edge_scratch_cap){
+        cap = fl->edge_scratch_cap = fl_scratch_cap(fl->edge_scratch_cap, fl->nedge);
+        fl->succ = (int *)fl_resize(fl->succ, cap * sizeof(int));
+        fl->pred = (int *)fl_resize(fl->pred, cap * sizeof(int));
+    }
+    memset(fl->succ_off, 0, (nb + 1) * sizeof(int));
+    memset(fl->pred_off, 0, (nb + 1) * sizeof(int));
+    for(i = 0; i < fl->nedge; i++){ fl->succ_off[fl->edge[i].from + 1]++; fl->pred_off[fl->edge[i].to + 1]++; }
+    for(i = 0; i < nb; i++){ fl->succ_off[i + 1] += fl->succ_off[i]; fl->pred_off[i + 1] += fl->pred_off[i]; }
+    // each offset is used as a fill cursor, which leaves it at the next list's start
+    for(i = 0; i < fl->nedge; i++){
+        fl->succ[fl->succ_off[fl->edge[i].from]++] = fl->edge[i].to;
+        fl->pred[fl->pred_off[fl->edge[i].to]++] = fl->edge[i].from;
+    }
+    for(i = nb; i > 0; i--){ fl->succ_off[i] = fl->succ_off[i - 1]; fl->pred_off[i] = fl->pred_off[i - 1]; }
+    fl->succ_off[0] = fl->pred_off[0] = 0;
+
+    // depth-first from the entry, with queue[] as the stack and slice_of[]
+    // (free until the solver runs) as each block's place in its successors
+    memset(fl->mark, 0, nb);
+    fl->nreach = 0;
+    sp = 0;
+    fl->queue[sp++] = FL_ENTRY;
+    fl->slice_of[FL_ENTRY] = fl->succ_off[FL_ENTRY];
+    fl->mark[FL_ENTRY] = 1;
+    while(sp > 0){
+        int b = fl->queue[sp - 1];
+        if(fl->slice_of[b] == fl->succ_off[b + 1]){
+            fl->post[b] = fl->nreach;
+            fl->order[fl->nreach++] = b;
+            sp--;
+            continue;
+        }
+        int x = fl->succ[fl->slice_of[b]++];
+        if(fl->mark[x]) continue;
+        fl->mark[x] = 1;
+        fl->slice_of[x] = fl->succ_off[x];
+        fl->queue[sp++] = x;
+    }
+}
+
+// unreachable statements: one finding per region, at its first statement
+static inline void fl_check_reach(fl_state *fl){
+    int nb = fl->nblk, b, i, head, tail;
+    for(b = 0; b < nb; b++){
+        if(fl->mark[b] || fl->blk[b].first == SM_NONE) continue;
+        fl_report(fl, FL_F_UNREACHABLE, fl->blk[b].first, -1);
+        // the code it leads to is part of the same region
+        head = tail = 0;
+        fl->queue[tail++] = b;
+        fl->mark[b] = 2;
+        while(head < tail){
+            int x = fl->queue[head++];
+            for(i = fl->succ_off[x]; i < fl->succ_off[x + 1]; i++)
+                if(!fl->mark[fl->succ[i]]){ fl->mark[fl->succ[i]] = 2; fl->queue[tail++] = fl->succ[i]; }
+        }
+    }
+}
+
+#define FL_HAS(set, i) (((set)[(i) >> 6] >> ((i) & 63)) & 1)
+#define FL_SET(set, i) ((set)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+
+// The sets of block b in the current slice: w words of flow facts (in
+// forward, live-out backward) then w words of kill bits (the block
+// writes the variable).  A block joins the slice, its sets cleared, the
+// first time something reaches it.
+static inline uint64_t *fl_slice_sets(fl_state *fl, int b, size_t w){
+    uint64_t *s = fl->sets + (size_t)b * 2 * w;
+    if(fl->slice_of[b] != fl->slice){
+        fl->slice_of[b] = fl->slice;
+        memset(s, 0, 2 * w * sizeof(uint64_t));
+    }
+    return s;
+}
+
+// whether bit j holds in block b's flow facts for this slice
+static inline int fl_slice_has(const fl_state *fl, int b, int j, size_t w){
+    return fl->slice_of[b] == fl->slice && FL_HAS(fl->sets + (size_t)b * 2 * w, j);
+}
+
+// place of block b in the sweep order: reverse postorder forward,
+// postorder backward, so that a block's inputs are mostly final by the
+// time the sweep reaches it
+static inline int fl_sweep_place(const fl_state *fl, int b, int forward){
+    return forward ? fl->nreach - 1 - fl->post[b] : fl->post[b];
+}
+
+static inline int fl_ctz64(uint64_t x){
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// ORs bits into the facts of block x, and marks x for another visit
+// (mark 3) if that added any.  Reachable blocks are mark 1, or 3 while
+// waiting for their visit.
+static inline void fl_slice_add(fl_state *fl, int x, const uint64_t *bits, const uint64_t *mask, size_t w, int forward){
+    uint64_t *s = fl_slice_sets(fl, x, w), changed = 0;
+    size_t k;
+    for(k = 0; k < w; k++){
+        uint64_t n = bits[k] & ~(mask ? mask[k] : 0) & ~s[k];
+        s[k] |= n;
+        changed |= n;
+    }
+    if(!changed || fl->mark[x] != 1) return;
+    fl->mark[x] = 3;
+    FL_SET(fl->dirty, fl_sweep_place(fl, x, forward));
+    fl->ndirty++;
+}
+
+// Solves one slice: bits seeded by fl_slice_seed flow along the edges
+// (successors forward, predecessors backward) through every reachable
+// block that does not kill them.  The marked blocks are visited in
+// sweeps in the order of fl_sweep_place, each sweep finding them in
+// the dirty bitmap a word at a time; on the structured graphs the
+// statements give, that settles in loop depth + 2 sweeps, and a sweep
+// costs the blocks it visits plus nreach / 64 words.
+static inline void fl_slice_solve(fl_state *fl, size_t w, int forward){
+    const int *off = forward ? fl->succ_off : fl->pred_off, *next = forward ? fl->succ : fl->pred;
+    int words = (fl->nreach + 63) / 64, k, i;
+    while(fl->ndirty > 0){
+        for(k = 0; k < words; k++){
+            while(fl->dirty[k]){
+                int at = k * 64 + fl_ctz64(fl->dirty[k]);
+                int b = fl->order[forward ? fl->nreach - 1 - at : at];
+                fl->dirty[k] &= fl->dirty[k] - 1;
+                fl->ndirty--;
+                fl->mark[b] = 1;
+                const uint64_t *s = fl_slice_sets(fl, b, w);
+                for(i = off[b]; i < off[b + 1]; i++)
+                    if(fl->mark[next[i]] & 1) fl_slice_add(fl, next[i], s, s + w, w, forward);
+            }
+        }
+    }
+}
+
+// bit j leaves block b: into the facts of its reachable neighbours
+static inline void fl_slice_seed(fl_state *fl, int b, int j, size_t w, int forward){
+    const int *off = forward ? fl->succ_off : fl->pred_off, *next = forward ? fl->succ : fl->pred;
+    uint64_t *bit = fl->sets + (size_t)fl->nblk * 2 * w;
+    int i;
+    memset(bit, 0, w * sizeof(uint64_t));
+    FL_SET(bit, j);
+    for(i = off[b]; i < off[b + 1]; i++)
+        if(fl->mark[next[i]] & 1) fl_slice_add(fl, next[i], bit, NULL, w, forward);
+}
+
+// a definition the liveness pass checks: a value stored and not read in
+// its own block
+static inline int fl_store(const fl_state *fl, const fl_def *d){
+    return (d->kind == FL_K_ASSIGN || d->kind == FL_K_INIT) && !d->used && fl->mark[d->block] == 1;
+}
+
+// Reaching definitions for variables whose declaration leaves them
+// unassigned at the end of its block (cand[0..n), 64 * w at a time):
+// the bit flows forward from there and stops at blocks writing the
+// variable.  The first read (in program order) exposed in a block the
+// bit reaches is reported.
+static inline void fl_solve_unassigned(fl_state *fl, int n, size_t w){
+    int base, j, d, u;
+    for(base = 0; base < n; base += (int)(64 * w)){
+        int m = n - base < (int)(64 * w) ? n - base : (int)(64 * w);
+        fl->slice++;
+        for(j = 0; j < m; j++)
+            for(d = fl->var[fl->cand[base + j]].first_def; d >= 0; d = fl->def[d].next)
+                FL_SET(fl_slice_sets(fl, fl->def[d].block, w) + w, j);
+        for(j = 0; j < m; j++) fl_slice_seed(fl, fl->def[fl->var[fl->cand[base + j]].decl_def].block, j, w, 1);
+        fl_slice_solve(fl, w, 1);
+        for(j = 0; j < m; j++){
+            fl_var *x = &fl->var[fl->cand[base + j]];
+            int first = -1;
+            for(u = x->first_use; u >= 0; u = fl->use[u].next)
+                if(fl->mark[fl->use[u].block] == 1 && fl_slice_has(fl, fl->use[u].block, j, w)) first = u;
+            if(first >= 0){
+                x->reported = 1;
+                fl_report(fl, FL_F_UNASSIGNED, fl->use[first].pos, x->name);
+            }
+        }
+    }
+}
+
+// Liveness for variables with a stored value to check (cand[0..n)): the
+// bit flows backward from the blocks that read the variable before
+// writing it, into the live-out set of each predecessor, and on through
+// the ones that do not write it.  A store is dead when its block's
+// live-out set lacks the bit.
+static inline void fl_solve_live(fl_state *fl, int n, size_t w){
+    int base, j, d, u;
+    for(base = 0; base < n; base += (int)(64 * w)){
+        int m = n - base < (int)(64 * w) ? n - base : (int)(64 * w);
+        fl->slice++;
+        for(j = 0; j < m; j++)
+            for(d = fl->var[fl->cand[base + j]].first_def; d >= 0; d = fl->def[d].next)
+                FL_SET(fl_slice_sets(fl, fl->def[d].block, w) + w, j);
+        for(j = 0; j < m; j++)
+            for(u = fl->var[fl->cand[base + j]].first_use; u >= 0; u = fl->use[u].next)
+                if(fl->mark[fl->use[u].block] & 1) fl_slice_seed(fl, fl->use[u].block, j, w, 0);
+        fl_slice_solve(fl, w, 0);
+        for(j = 0; j < m; j++){
+            const fl_var *x = &fl->var[fl->cand[base + j]];
+            for(d = x->first_def; d >= 0; d = fl->def[d].next)
+                if(fl_store(fl, &fl->def[d]) && !fl_slice_has(fl, fl->def[d].block, j, w))
+                    fl_report(fl, FL_F_DEAD_STORE, fl->def[d].pos, x->name);
+        }
+    }
+}
+
+// slice width in words for n variables: as wide as they need, up to
+// FL_SLICE_WORDS and to FL_SLICE_BYTES of sets over the function's blocks
+static inline size_t fl_slice_words(const fl_state *fl, int n){
+    size_t w = ((size_t)n + 63) / 64, fit = FL_SLICE_BYTES / (2 * sizeof(uint64_t) * (size_t)fl->nblk);
+    if(w > FL_SLICE_WORDS) w = FL_SLICE_WORDS;
+    if(w > fit) w = fit ? fit : 1;
+    return w;
+}
+
+static inline void fl_slice_alloc(fl_state *fl, size_t w){
+    size_t words = (2 * (size_t)fl->nblk + 1) * w;
+    if(words > fl->sets_cap){
+        fl->sets_cap = words;
+        fl->sets = (uint64_t *)fl_resize(fl->sets, words * sizeof(uint64_t));
+    }
+}
+
+static inline void fl_analyze(fl_state *fl){
+    int i, v, d, n;
+    fl_build_graph(fl);
+    fl_check_reach(fl);
+    memset(fl->slice_of, 0, fl->nblk * sizeof(int));
+    memset(fl->dirty, 0, (fl->nreach + 63) / 64 * sizeof(uint64_t));
+    fl->slice = fl->ndirty = 0;
+    fl->cand = (int *)fl_grow(fl->cand, &fl->cand_cap, fl->nvar, sizeof(int));
+
+    // reaching definitions: variables declared unassigned, with reads
+    // the in-block check has not already reported
+    for(n = v = 0; v < fl->nvar; v++){
+        const fl_var *x = &fl->var[v];
+        d = x->decl_def;
+        if(!x->escaped && !x->reported && x->first_use >= 0 && d >= 0 && fl->def[d].kind == FL_K_UNDEF &&
+           fl->mark[fl->def[d].block] == 1) fl->cand[n++] = v;
+    }
+    if(n > 0){
+        size_t w = fl_slice_words(fl, n);
+        fl_slice_alloc(fl, w);
+        fl_solve_unassigned(fl, n, w);
+    }
+
+    // liveness: variables with a store no read in its own block follows
+    for(n = v = 0; v < fl->nvar; v++){
+        const fl_var *x = &fl->var[v];
+        if(x->escaped) continue;
+        for(d = x->first_def; d >= 0 && !fl_store(fl, &fl->def[d]); d = fl->def[d].next)
+            ;
+        if(d >= 0) fl->cand[n++] = v;
+    }
+    if(n > 0){
+        size_t w = fl_slice_words(fl, n);
+        fl_slice_alloc(fl, w);
+        fl_solve_live(fl, n, w);
+    }
+
+    for(i = 0; i < fl->nlabel; i++)
+        if(!fl->label[i].targeted) fl_report(fl, FL_F_LABEL_UNUSED, fl->label[i].pos, fl->label[i].name);
+}
+
+#endif /* FLOW_H */
@@ -0,0 +1,280 @@
+#ifndef LEXER_CORE_H
+#define LEXER_CORE_H
+/* lexer_core.h
+    Line-at-a-time lexer shared by project_lexer.c and the parser's
+    pipelined mode (MSVC-compatible C89, header only)
+    Each token goes to ls->emit as (token, lexeme); the lexeme is NULL
+    for SYM(x) tokens.  When ls->tok is set, lex_line also stores each
+    token there as its kind and its bytes in the line (ls->ntok of them),
+    which is what the parser consumes.  On a lexical error lex_line
+    returns 0 and leaves the message in ls->err.
+*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "lexer_tables.h"
+#include "memprof.h"
+
+#define LEX_MAXLINE 1024
+
+#define LEX_IS(c, cls) (lex_cclass[(unsigned char)(c)] & (cls))
+
+typedef void (*lex_emit_fn)(void *ctx, const char *tok, const char *lex);
+
+/* kinds of stored token */
+enum {
+    LEX_K_WORD, LEX_K_LABEL, LEX_K_NUM, LEX_K_STRING, LEX_K_CHAR, LEX_K_STMT_END,
+    LEX_K_SYM, LEX_K_INCLUDE, LEX_K_COMMENT
+};
+
+typedef struct {
+    unsigned short at, len;         /* bytes [at, at + len) of the line; quotes included */
+    unsigned char kind;             /* LEX_K_* */
+} lex_tok;
+
+typedef struct {
+    lex_emit_fn emit;
+    void *ctx;
+    int saw_main;
+    char err[128];
+    lex_tok *tok;                   /* NULL, or room for one token per byte of the line */
+    int ntok;                       /* tokens the last lex_line stored */
+} lex_state;
+
+static inline int is_include_line(const char *s)
+{
+    char tmp[LEX_MAXLINE];
+    int n;
+    strcpy(tmp, s);
+    while (*tmp && LEX_IS(*tmp, LEX_C_SPACE))
+        memmove(tmp, tmp + 1, strlen(tmp));
+    n = strlen(tmp);
+    while (n > 0 && LEX_IS(tmp[n - 1], LEX_C_SPACE))
+        tmp[--n] = 0;
+    return strcmp(tmp, "#include<stdio.h>") == 0 || 
+           strcmp(tmp, "#include <stdio.h>") == 0;
+}
+
+static inline int is_comment_line(const char *s)
+{
+    const char *p;
+    p = s;
+    while (*p && LEX_IS(*p, LEX_C_SPACE)) p++;
+    if (p[0] == '/' && p[1] == '/') {
+        p += 2;
+        while (*p) {
+            if (!LEX_IS(*p, LEX_C_COMMENT_CHAR))
+                return 0;
+            p++;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static inline int lex_fail(lex_state *ls, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(ls->err, sizeof(ls->err), fmt, ap);
+    va_end(ap);
+    return 0;
+}
+
+static inline void lex_init(lex_state *ls, lex_emit_fn emit, void *ctx)
+{
+    ls->emit = emit;
+    ls->ctx = ctx;
+    ls->saw_main = 0;
+    ls->err[0] = 0;
+    ls->tok = NULL;
+    ls->ntok = 0;
+}
+
+/* Stores the token at line[at .. at + len) if the caller keeps them. */
+static inline void lex_keep(lex_state *ls, int kind, int at, int len)
+{
+    lex_tok *t;
+    if (!ls->tok) return;
+    t = &ls->tok[ls->ntok++];
+    t->at = (unsigned short)at;
+    t->len = (unsigned short)len;
+    t->kind = (unsigned char)kind;
+}
+
+/* Lexes one source line (without its newline); lineno starts at 1. */
+static inline int lex_line(lex_state *ls, const char *line, int lineno)
+{
+    char tmp[LEX_MAXLINE];
+    char id[256];
+    char buf[256];
+    char num[64];
+    char tmp2[16];
+    char *s;
+    char *ptrim;
+    char *start;
+    int allspace, i, tag;
+
+    MP_FRAME(MP_F_LEX_LINE);
+    ls->ntok = 0;
+    if (lineno == 1) {
+        if (!is_include_line(line))
+            return lex_fail(ls, "Error: first line must be #include<stdio.h>");
+        lex_keep(ls, LEX_K_INCLUDE, 0, (int)strlen(line));
+        ls->emit(ls->ctx, "INCLUDE", "#include<stdio.h>");
+        return 1;
+    }
+
+    strcpy(tmp, line);
+    allspace = 1;
+    for (i = 0; i < (int)strlen(tmp); i++) {
+        if (!LEX_IS(tmp[i], LEX_C_SPACE)) {
+            allspace = 0;
+            break;
+        }
+    }
+    if (allspace) return 1;
+
+    ptrim = tmp;
+    while (*ptrim && LEX_IS(*ptrim, LEX_C_SPACE)) ptrim++;
+    /* allow other preprocessor/include lines after first line (e.g. #include <string.h>) */
+    if (ptrim[0] == '#') {
+        /* emit the whole trimmed line as INCLUDE */
+        lex_keep(ls, LEX_K_INCLUDE, (int)(ptrim - tmp), (int)strlen(ptrim));
+        ls->emit(ls->ctx, "INCLUDE", ptrim);
+        return 1;
+    }
+    if (ptrim[0] == '/' && ptrim[1] == '/') {
+        if (!is_comment_line(ptrim))
+            return lex_fail(ls, "Error: invalid comment at line %d", lineno);
+        lex_keep(ls, LEX_K_COMMENT, (int)(ptrim - tmp), (int)strlen(ptrim));
+        ls->emit(ls->ctx, "COMMENT", ptrim + 2);
+        return 1;
+    }
+
+    s = tmp;
+    while (*s) {
+        if (LEX_IS(*s, LEX_C_SPACE)) {
+            s++;
+            continue;
+        }
+
+        if (strncmp(s, "loop_", 5) == 0) {
+            i = 0;
+            while (s[i] && !LEX_IS(s[i], LEX_C_SPACE) && s[i] != '{' && s[i] != '(') {
+                buf[i] = s[i];
+                i++;
+            }
+            buf[i] = 0;
+            if (buf[i - 1] == ':') {
+                /* the word only has to start with a well-formed label */
+                if (dfa_match_len(&lex_label_dfa, buf, i) < 0)
+                    return lex_fail(ls, "Error: invalid loop label at line %d", lineno);
+                lex_keep(ls, LEX_K_LABEL, (int)(s - tmp), i);
+                ls->emit(ls->ctx, "LOOP_LABEL", buf);
+                s += i;
+                continue;
+            }
+        }
+
+        if (LEX_IS(*s, LEX_C_IDENT_START)) {
+            i = 0;
+            while (s[i] && LEX_IS(s[i], LEX_C_IDENT_CHAR)) {
+                id[i] = s[i];
+                i++;
+            }
+            id[i] = 0;
+            tag = dfa_classify(&lex_ident_dfa, id, i);
+            lex_keep(ls, LEX_K_WORD, (int)(s - tmp), i);
+            if (tag != LEX_TOK_NONE) {
+                ls->emit(ls->ctx, lex_token_name[tag], id);
+                if (tag == LEX_TOK_MAIN) ls->saw_main = 1;
+            } else {
+                ls->emit(ls->ctx, "IDENT", id);
+            }
+            s += i;
+            continue;
+        }
+
+        if (LEX_IS(*s, LEX_C_DIGIT)) {
+            i = 0;
+            while (LEX_IS(s[i], LEX_C_DIGIT)) {
+                num[i] = s[i];
+                i++;
+            }
+            num[i] = 0;
+            lex_keep(ls, LEX_K_NUM, (int)(s - tmp), i);
+            ls->emit(ls->ctx, "NUM", num);
+            s += i;
+            continue;
+        }
+
+        if (s[0] == '.' && s[1] == '.') {
+            lex_keep(ls, LEX_K_STMT_END, (int)(s - tmp), 2);
+            ls->emit(ls->ctx, "STMT_END", "..");
+            s += 2;
+            continue;
+        }
+
+        /* handle C-style string literals ("...") by capturing them as STRING tokens */
+        if (s[0] == '"') {
+            int si = 0;
+            char strlit[512];
+            start = s;
+            s++; /* skip opening quote */
+            while (*s) {
+                if (*s == '\\' && s[1]) {
+                    /* keep escaped char */
+                    if (si < (int)sizeof(strlit)-2) {
+                        strlit[si++] = *s;
+                        strlit[si++] = s[1];
+                    }
+                    s += 2;
+                    continue;
+                }
+                if (*s == '"') { s++; break; }
+                if (si < (int)sizeof(strlit)-1) strlit[si++] = *s;
+                s++;
+            }
+            strlit[si] = 0;
+            lex_keep(ls, LEX_K_STRING, (int)(start - tmp), (int)(s - start));
+            ls->emit(ls->ctx, "STRING", strlit);
+            continue;
+        }
+
+        /* handle C-style character literals ('a' or '\n') */
+        if (s[0] == '\'') {
+            int si = 0;
+            char charlit[16];
+            start = s;
+            s++; /* skip opening quote */
+            if (*s == '\\' && s[1]) {
+                /* escaped char */
+                charlit[si++] = *s; charlit[si++] = s[1]; s += 2;
+            } else if (*s) {
+                charlit[si++] = *s; s++;
+            }
+            /* skip closing quote if present */
+            if (*s == '\'') s++;
+            charlit[si] = 0;
+            lex_keep(ls, LEX_K_CHAR, (int)(start - tmp), (int)(s - start));
+            ls->emit(ls->ctx, "CHAR", charlit);
+            continue;
+        }
+
+        /* accept additional C operators/symbols: ? | [ ] and keep existing ones */
+        if (LEX_IS(*s, LEX_C_SYMBOL)) {
+            snprintf(tmp2, sizeof(tmp2), "SYM(%c)", *s);
+            lex_keep(ls, LEX_K_SYM, (int)(s - tmp), 1);
+            ls->emit(ls->ctx, tmp2, NULL);
+            s++;
+            continue;
+        }
+
+        return lex_fail(ls, "Error: invalid character '%c' at line %d", *s, lineno);
+    }
+    return 1;
+}
+
+#endif /* LEXER_CORE_H */
@@ -0,0 +1,214 @@
+/* lexer_tables.h
+    Generated by lexgen.exe from lexer_spec.txt -- do not edit.
+*/
+#ifndef LEXER_TABLES_H
+#define LEXER_TABLES_H
+
+#include "dfa_table.h"
+
+#define LEX_C_SPACE            0x01
+#define LEX_C_ALPHA            0x02
+#define LEX_C_DIGIT            0x04
+#define LEX_C_IDENT_START      0x08
+#define LEX_C_IDENT_CHAR       0x10
+#define LEX_C_SYMBOL           0x20
+#define LEX_C_COMMENT_CHAR     0x40
+
+static const unsigned char lex_cclass[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 65, 65, 65, 65, 65, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    65, 0, 0, 0, 0, 0, 0, 0, 32, 32, 32, 32, 32, 32, 0, 32,
+    20, 20, 20, 20, 20, 20, 20, 20, 20, 20, 32, 32, 32, 32, 32, 32,
+    0, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90,
+    90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 32, 0, 32, 0, 24,
+    0, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90,
+    90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 90, 32, 32, 32, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#define LEX_TOK_NONE 0
+#define LEX_TOK_TYPE 1
+#define LEX_TOK_WHILE 2
+#define LEX_TOK_PRINTF 3
+#define LEX_TOK_RETURN 4
+#define LEX_TOK_BREAK 5
+#define LEX_TOK_FUNC_NAME 6
+#define LEX_TOK_VAR 7
+#define LEX_TOK_MAIN 8
+#define LEX_TOK_LOOP_LABEL 9
+
+static const char *const lex_token_name[10] = {
+    "",
+    "TYPE",
+    "WHILE",
+    "PRINTF",
+    "RETURN",
+    "BREAK",
+    "FUNC_NAME",
+    "VAR",
+    "MAIN",
+    "LOOP_LABEL"
+};
+
+/* dfa ident: 41 states, 22 byte classes, dense16 */
+static const unsigned short lex_ident_t16[902] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    44, 44, 66, 44, 88, 44, 110, 44, 44, 44, 132, 44,
+    44, 154, 44, 176, 198, 44, 44, 220, 0, 0, 44, 242,
+    0, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 0, 0, 264, 264, 0, 264,
+    264, 264, 264, 264, 264, 264, 264, 264, 264, 264, 264, 264,
+    264, 264, 264, 264, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 286, 44,
+    44, 44, 0, 0, 44, 242, 0, 44, 44, 44, 44, 308,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    0, 0, 44, 242, 0, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 330, 44, 44, 44, 44, 44, 0, 0,
+    44, 242, 0, 352, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 0, 0, 44, 242,
+    0, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 374, 44, 44, 44, 0, 0, 44, 242, 0, 44,
+    44, 44, 44, 396, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 418, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 0, 0, 44, 242, 0, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 704, 44, 44, 44, 44, 44,
+    0, 440, 264, 264, 0, 264, 264, 264, 264, 264, 264, 264,
+    264, 264, 264, 264, 264, 264, 264, 264, 264, 264, 0, 0,
+    44, 242, 0, 44, 44, 44, 44, 462, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 0, 0, 44, 242,
+    0, 44, 44, 726, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 0, 0, 44, 242, 0, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 748, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 484, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 0, 0, 44, 242, 0, 44, 44, 44, 44, 44,
+    44, 44, 506, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    0, 0, 44, 242, 0, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 528, 44, 44, 0, 0,
+    44, 242, 0, 44, 44, 44, 44, 44, 44, 44, 550, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 0, 0, 770, 770,
+    0, 770, 770, 770, 770, 770, 770, 770, 770, 770, 770, 770,
+    770, 770, 770, 770, 770, 770, 0, 0, 44, 242, 0, 572,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 792, 44, 44, 44,
+    44, 44, 0, 0, 44, 242, 0, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 594, 44, 44, 44, 44, 44,
+    0, 0, 44, 242, 0, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 616, 44, 0, 0,
+    44, 242, 0, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    638, 44, 44, 44, 44, 44, 44, 44, 0, 0, 44, 242,
+    0, 44, 44, 44, 44, 44, 44, 44, 44, 814, 44, 44,
+    44, 44, 44, 44, 44, 44, 0, 0, 44, 242, 0, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 660, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 682, 44,
+    44, 44, 0, 0, 44, 242, 0, 44, 44, 44, 44, 836,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    0, 0, 44, 242, 0, 44, 44, 44, 44, 44, 858, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 0, 0,
+    44, 242, 0, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 880, 44, 44, 44, 44, 44, 0, 0, 44, 242,
+    0, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 0, 0, 44, 242, 0, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 44, 242, 0, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 0, 0,
+    44, 242, 0, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 0, 0, 44, 242,
+    0, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 0, 0, 44, 242, 0, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44, 44, 44, 0, 0, 44, 242, 0, 44, 44, 44,
+    44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44, 44,
+    44, 44
+};
+static const unsigned char lex_ident_tag[41] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    6, 1, 1, 7, 8, 5, 2, 3, 4
+};
+static const dfa_table lex_ident_dfa = {
+    DFA_DENSE16, 41, 22, 22, 704,
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+        0, 2, 2, 2, 2, 2, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 4,
+        0, 5, 6, 7, 8, 9, 10, 2, 11, 12, 2, 13, 14, 15, 16, 2,
+        17, 2, 18, 2, 19, 20, 2, 21, 2, 2, 2, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    },
+    NULL,
+    lex_ident_t16,
+    NULL,
+    NULL,
+    NULL,
+    0,
+    lex_ident_tag
+};
+
+/* dfa label: 11 states, 8 byte classes, dense8 */
+static const unsigned char lex_label_t8[88] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 0, 0,
+    0, 0, 0, 0, 0, 0, 24, 0, 0, 0, 0, 0, 0, 0, 32, 0,
+    0, 0, 0, 0, 0, 0, 0, 40, 0, 0, 0, 0, 48, 0, 0, 0,
+    0, 0, 0, 56, 0, 56, 56, 56, 0, 64, 0, 56, 0, 56, 56, 56,
+    0, 72, 0, 0, 0, 0, 0, 0, 0, 0, 80, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+static const unsigned char lex_label_tag[11] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9
+};
+static const dfa_table lex_label_dfa = {
+    DFA_DENSE8, 11, 8, 8, 80,
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0,
+        0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 4,
+        0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 5, 3, 3, 6,
+        7, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    },
+    lex_label_t8,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    0,
+    lex_label_tag
+};
+
+#endif /* LEXER_TABLES_H */
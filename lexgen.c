@@ -0,0 +1,491 @@
+/* lexgen.c
+    Build-step generator for the lexer tables
+    Reads lexer_spec.txt and writes lexer_tables.h:
+      - lex_cclass[256], one LEX_C_* bit per character class
+      - one static dfa_table per "dfa" section (regex -> NFA -> DFA,
+        packed with dfa_build from dfa_table.h)
+      - LEX_TOK_* tags and their names
+    Usage: lexgen.exe lexer_spec.txt lexer_tables.h
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "dfa_table.h"
+
+#define MAXLINE 1024
+#define MAXCLASS 8
+#define MAXTOK 64
+#define MAXDFA 8
+#define MAXRULE 32
+#define MAXNODE 1024
+#define MAXSET 256
+#define MAXDSTATE 512
+
+typedef struct {
+    int set;        /* index into sets[] or -1 */
+    int out;        /* target of the set transition */
+    int eps[2];     /* epsilon targets or -1 */
+    int rule;       /* accepting rule index or -1 */
+} nfa_node;
+
+typedef struct {
+    int start, end;
+} frag;
+
+static char class_name[MAXCLASS][32];
+static unsigned char class_bits[256];
+static int nclass;
+
+static char tok_name[MAXTOK][32];
+static int ntok;
+
+static char dfa_name[MAXDFA][32];
+static char rule_re[MAXDFA][MAXRULE][256];
+static int rule_tok[MAXDFA][MAXRULE];
+static int nrule[MAXDFA];
+static int ndfa;
+
+static nfa_node nodes[MAXNODE];
+static int nnode;
+static unsigned char sets[MAXSET][256];
+static int nset;
+
+static const char *re_p;
+static int lineno;
+
+static void die(const char *msg)
+{
+    fprintf(stderr, "lexgen: line %d: %s\n", lineno, msg);
+    exit(1);
+}
+
+static int hexval(char c)
+{
+    if (isdigit((unsigned char)c)) return c - '0';
+    return tolower((unsigned char)c) - 'a' + 10;
+}
+
+static int parse_escape(const char **pp)
+{
+    const char *p = *pp;
+    int c;
+    switch (*p) {
+    case 's': c = ' '; break;
+    case 't': c = '\t'; break;
+    case 'n': c = '\n'; break;
+    case 'r': c = '\r'; break;
+    case 'v': c = '\v'; break;
+    case 'f': c = '\f'; break;
+    case 'x':
+        if (!isxdigit((unsigned char)p[1]) || !isxdigit((unsigned char)p[2]))
+            die("bad \\x escape");
+        c = hexval(p[1]) * 16 + hexval(p[2]);
+        p += 2;
+        break;
+    case 0: die("dangling backslash"); return 0;
+    default: c = (unsigned char)*p; break;
+    }
+    *pp = p + 1;
+    return c;
+}
+
+/* Parses a set body up to end (or ']' when stop_at_bracket). */
+static void parse_set(const char **pp, unsigned char *set, int stop_at_bracket)
+{
+    const char *p = *pp;
+    int lo, hi, c;
+
+    memset(set, 0, 256);
+    while (*p && !(stop_at_bracket && *p == ']')) {
+        if (*p == '\\') {
+            p++;
+            lo = parse_escape(&p);
+        } else {
+            lo = (unsigned char)*p++;
+        }
+        hi = lo;
+        if (p[0] == '-' && p[1] && !(stop_at_bracket && p[1] == ']')) {
+            p++;
+            if (*p == '\\') {
+                p++;
+                hi = parse_escape(&p);
+            } else {
+                hi = (unsigned char)*p++;
+            }
+        }
+        if (hi < lo) die("bad range");
+        for (c = lo; c <= hi; c++) set[c] = 1;
+    }
+    *pp = p;
+}
+
+static int new_node(void)
+{
+    if (nnode == MAXNODE) die("too many NFA nodes");
+    nodes[nnode].set = -1;
+    nodes[nnode].out = -1;
+    nodes[nnode].eps[0] = -1;
+    nodes[nnode].eps[1] = -1;
+    nodes[nnode].rule = -1;
+    return nnode++;
+}
+
+static void add_eps(int from, int to)
+{
+    if (nodes[from].eps[0] < 0) nodes[from].eps[0] = to;
+    else if (nodes[from].eps[1] < 0) nodes[from].eps[1] = to;
+    else die("internal: node has two epsilon edges");
+}
+
+static frag set_frag(const unsigned char *set)
+{
+    frag f;
+    if (nset == MAXSET) die("too many character sets");
+    memcpy(sets[nset], set, 256);
+    f.start = new_node();
+    f.end = new_node();
+    nodes[f.start].set = nset++;
+    nodes[f.start].out = f.end;
+    return f;
+}
+
+static frag re_alt(void);
+
+static frag re_atom(void)
+{
+    unsigned char set[256];
+    frag f;
+
+    if (*re_p == '(') {
+        re_p++;
+        f = re_alt();
+        if (*re_p != ')') die("missing ')'");
+        re_p++;
+        return f;
+    }
+    if (*re_p == '[') {
+        re_p++;
+        parse_set(&re_p, set, 1);
+        if (*re_p != ']') die("missing ']'");
+        re_p++;
+        return set_frag(set);
+    }
+    memset(set, 0, sizeof(set));
+    if (*re_p == '\\') {
+        re_p++;
+        set[parse_escape(&re_p)] = 1;
+    } else {
+        set[(unsigned char)*re_p++] = 1;
+    }
+    return set_frag(set);
+}
+
+static frag re_repeat(void)
+{
+    frag f, g;
+
+    f = re_atom();
+    while (*re_p == '*' || *re_p == '+' || *re_p == '?') {
+        g.start = new_node();
+        g.end = new_node();
+        add_eps(g.start, f.start);
+        add_eps(f.end, g.end);
+        if (*re_p != '+') add_eps(g.start, g.end);
+        if (*re_p != '?') add_eps(f.end, f.start);
+        f = g;
+        re_p++;
+    }
+    return f;
+}
+
+static frag re_concat(void)
+{
+    frag f, g;
+
+    f = re_repeat();
+    while (*re_p && *re_p != '|' && *re_p != ')') {
+        g = re_repeat();
+        add_eps(f.end, g.start);
+        f.end = g.end;
+    }
+    return f;
+}
+
+static frag re_alt(void)
+{
+    frag f, g, h;
+
+    f = re_concat();
+    while (*re_p == '|') {
+        re_p++;
+        g = re_concat();
+        h.start = new_node();
+        h.end = new_node();
+        add_eps(h.start, f.start);
+        add_eps(h.start, g.start);
+        add_eps(f.end, h.end);
+        add_eps(g.end, h.end);
+        f = h;
+    }
+    return f;
+}
+
+static void closure(unsigned char *in)
+{
+    int stack[MAXNODE], sp = 0, n, k, e;
+
+    for (n = 0; n < nnode; n++)
+        if (in[n]) stack[sp++] = n;
+    while (sp > 0) {
+        n = stack[--sp];
+        for (k = 0; k < 2; k++) {
+            e = nodes[n].eps[k];
+            if (e >= 0 && !in[e]) {
+                in[e] = 1;
+                stack[sp++] = e;
+            }
+        }
+    }
+}
+
+static int find_token(const char *name)
+{
+    int i;
+    for (i = 0; i < ntok; i++)
+        if (strcmp(tok_name[i], name) == 0) return i + 1;
+    if (ntok == MAXTOK) die("too many tokens");
+    strcpy(tok_name[ntok++], name);
+    return ntok;
+}
+
+static void read_spec(FILE *f)
+{
+    char line[MAXLINE], name[64];
+    unsigned char set[256];
+    const char *p;
+    int c, n;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        line[strcspn(line, "\r\n")] = 0;
+        p = line;
+        while (*p && isspace((unsigned char)*p)) p++;
+        if (*p == 0 || *p == '#') continue;
+
+        if (sscanf(p, "%63s", name) != 1) continue;
+        p += strlen(name);
+        while (*p && isspace((unsigned char)*p)) p++;
+        if (strcmp(name, "class") == 0) {
+            if (nclass == MAXCLASS) die("too many classes");
+            if (sscanf(p, "%31s", class_name[nclass]) != 1) die("class needs a name");
+            p += strlen(class_name[nclass]);
+            while (*p && isspace((unsigned char)*p)) p++;
+            parse_set(&p, set, 0);
+            for (c = 0; c < 256; c++)
+                if (set[c]) class_bits[c] |= (unsigned char)(1 << nclass);
+            nclass++;
+        } else if (strcmp(name, "dfa") == 0) {
+            if (ndfa == MAXDFA) die("too many dfa sections");
+            if (sscanf(p, "%31s", dfa_name[ndfa]) != 1) die("dfa needs a name");
+            ndfa++;
+        } else {
+            if (ndfa == 0) die("rule outside of a dfa section");
+            if (nrule[ndfa - 1] == MAXRULE) die("too many rules");
+            n = (int)strlen(p);
+            while (n > 0 && isspace((unsigned char)p[n - 1])) n--;
+            if (n == 0) die("rule needs a regex");
+            if (n >= (int)sizeof(rule_re[0][0])) die("regex too long");
+            memcpy(rule_re[ndfa - 1][nrule[ndfa - 1]], p, n);
+            rule_re[ndfa - 1][nrule[ndfa - 1]][n] = 0;
+            rule_tok[ndfa - 1][nrule[ndfa - 1]] = find_token(name);
+            nrule[ndfa - 1]++;
+        }
+    }
+}
+
+static void upper(char *dst, const char *src)
+{
+    while (*src) *dst++ = (char)toupper((unsigned char)*src++);
+    *dst = 0;
+}
+
+static void emit_bytes(FILE *out, const char *type, const char *name, const unsigned char *v, int n)
+{
+    int i;
+    fprintf(out, "static const %s %s[%d] = {", type, name, n);
+    for (i = 0; i < n; i++)
+        fprintf(out, "%s%d%s", i % 16 == 0 ? "\n    " : " ", v[i], i + 1 < n ? "," : "\n");
+    fprintf(out, "};\n");
+}
+
+static void emit_shorts(FILE *out, const char *name, const unsigned short *v, int n)
+{
+    int i;
+    fprintf(out, "static const unsigned short %s[%d] = {", name, n);
+    for (i = 0; i < n; i++)
+        fprintf(out, "%s%d%s", i % 12 == 0 ? "\n    " : " ", v[i], i + 1 < n ? "," : "\n");
+    fprintf(out, "};\n");
+}
+
+static void emit_ref(FILE *out, int present, const char *dfa, const char *field)
+{
+    if (present)
+        fprintf(out, "    lex_%s_%s,\n", dfa, field);
+    else
+        fprintf(out, "    NULL,\n");
+}
+
+/* Builds DFA section k by subset construction and writes it out. */
+static void gen_dfa(FILE *out, int k)
+{
+    static unsigned char dset[MAXDSTATE][MAXNODE];
+    static int trans[MAXDSTATE * 256];
+    static unsigned char tags[MAXDSTATE];
+    unsigned char next[MAXNODE];
+    frag f;
+    dfa_table d;
+    char nm[64];
+    int start, fork, r, s, c, n, t, any, ndstate, best;
+
+    nnode = 0;
+    nset = 0;
+    start = new_node();
+    fork = start;
+    for (r = 0; r < nrule[k]; r++) {
+        re_p = rule_re[k][r];
+        f = re_alt();
+        if (*re_p) die("trailing characters in regex");
+        nodes[f.end].rule = r;
+        /* one fork node per rule keeps every node at two epsilon edges */
+        add_eps(fork, f.start);
+        if (r + 1 < nrule[k]) {
+            n = new_node();
+            add_eps(fork, n);
+            fork = n;
+        }
+    }
+
+    memset(dset[0], 0, MAXNODE);
+    dset[0][start] = 1;
+    closure(dset[0]);
+    ndstate = 1;
+    for (s = 0; s < ndstate; s++) {
+        best = -1;
+        for (n = 0; n < nnode; n++)
+            if (dset[s][n] && nodes[n].rule >= 0 && (best < 0 || nodes[n].rule < best))
+                best = nodes[n].rule;
+        tags[s] = (unsigned char)(best < 0 ? 0 : rule_tok[k][best]);
+
+        for (c = 0; c < 256; c++) {
+            memset(next, 0, nnode);
+            any = 0;
+            for (n = 0; n < nnode; n++) {
+                if (dset[s][n] && nodes[n].set >= 0 && sets[nodes[n].set][c]) {
+                    next[nodes[n].out] = 1;
+                    any = 1;
+                }
+            }
+            if (!any) {
+                trans[s * 256 + c] = -1;
+                continue;
+            }
+            closure(next);
+            for (t = 0; t < ndstate; t++)
+                if (memcmp(dset[t], next, nnode) == 0) break;
+            if (t == ndstate) {
+                if (ndstate == MAXDSTATE) die("too many DFA states");
+                memcpy(dset[ndstate], next, nnode);
+                ndstate++;
+            }
+            trans[s * 256 + c] = t;
+        }
+    }
+
+    if (dfa_build(&d, ndstate, trans, tags, 0, DFA_AUTO) != 0) die("could not pack DFA");
+
+    fprintf(out, "\n/* dfa %s: %d states, %d byte classes, %s */\n",
+            dfa_name[k], d.nstates, d.nclasses, dfa_layout_name(d.layout));
+    if (d.t8) {
+        snprintf(nm, sizeof(nm), "lex_%s_t8", dfa_name[k]);
+        emit_bytes(out, "unsigned char", nm, d.t8, d.nstates * d.nclasses);
+    }
+    if (d.t16) {
+        snprintf(nm, sizeof(nm), "lex_%s_t16", dfa_name[k]);
+        emit_shorts(out, nm, d.t16, d.nstates * d.nclasses);
+    }
+    if (d.base) {
+        snprintf(nm, sizeof(nm), "lex_%s_base", dfa_name[k]);
+        emit_shorts(out, nm, d.base, d.nstates);
+        snprintf(nm, sizeof(nm), "lex_%s_check", dfa_name[k]);
+        emit_shorts(out, nm, d.check, d.comb_len);
+        snprintf(nm, sizeof(nm), "lex_%s_next", dfa_name[k]);
+        emit_shorts(out, nm, d.next, d.comb_len);
+    }
+    snprintf(nm, sizeof(nm), "lex_%s_tag", dfa_name[k]);
+    emit_bytes(out, "unsigned char", nm, d.tag, d.nstates);
+
+    fprintf(out, "static const dfa_table lex_%s_dfa = {\n", dfa_name[k]);
+    fprintf(out, "    %s, %d, %d, %d, %d,\n    {", d.layout == DFA_DENSE8 ? "DFA_DENSE8" :
+            d.layout == DFA_DENSE16 ? "DFA_DENSE16" : "DFA_COMB16",
+            d.nstates, d.nclasses, d.start, d.accept_min);
+    for (c = 0; c < 256; c++)
+        fprintf(out, "%s%d%s", c % 16 == 0 ? "\n        " : " ", d.classmap[c], c < 255 ? "," : "\n    },\n");
+    emit_ref(out, d.t8 != NULL, dfa_name[k], "t8");
+    emit_ref(out, d.t16 != NULL, dfa_name[k], "t16");
+    emit_ref(out, d.base != NULL, dfa_name[k], "base");
+    emit_ref(out, d.base != NULL, dfa_name[k], "check");
+    emit_ref(out, d.base != NULL, dfa_name[k], "next");
+    fprintf(out, "    %d,\n    lex_%s_tag\n};\n", d.comb_len, dfa_name[k]);
+    dfa_free(&d);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in, *out;
+    char nm[64];
+    int i;
+
+    if (argc < 3) {
+        printf("Usage: %s <spec-file> <output-header>\n", argv[0]);
+        return 1;
+    }
+    in = fopen(argv[1], "r");
+    if (!in) {
+        perror("fopen");
+        return 1;
+    }
+    read_spec(in);
+    fclose(in);
+
+    out = fopen(argv[2], "w");
+    if (!out) {
+        perror("fopen");
+        return 1;
+    }
+    fprintf(out, "/* %s\n    Generated by lexgen.exe from %s -- do not edit.\n*/\n", argv[2], argv[1]);
+    fprintf(out, "#ifndef LEXER_TABLES_H\n#define LEXER_TABLES_H\n\n#include \"dfa_table.h\"\n\n");
+
+    for (i = 0; i < nclass; i++) {
+        upper(nm, class_name[i]);
+        fprintf(out, "#define LEX_C_%-16s 0x%02x\n", nm, 1 << i);
+    }
+    fprintf(out, "\n");
+    emit_bytes(out, "unsigned char", "lex_cclass", class_bits, 256);
+
+    fprintf(out, "\n#define LEX_TOK_NONE 0\n");
+    for (i = 0; i < ntok; i++)
+        fprintf(out, "#define LEX_TOK_%s %d\n", tok_name[i], i + 1);
+    fprintf(out, "\nstatic const char *const lex_token_name[%d] = {\n    \"\"", ntok + 1);
+    for (i = 0; i < ntok; i++)
+        fprintf(out, ",\n    \"%s\"", tok_name[i]);
+    fprintf(out, "\n};\n");
+
+    for (i = 0; i < ndfa; i++)
+        gen_dfa(out, i);
+
+    fprintf(out, "\n#endif /* LEXER_TABLES_H */\n");
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,227 @@
+#ifndef MEMPROF_H
+#define MEMPROF_H
+/* memprof.h
+    --mem-profile support for project_lexer.exe and project_parser.exe
+    The tools' own heap memory goes through mp_malloc / mp_realloc /
+    mp_free, tagged with the subsystem it belongs to.  With profiling on
+    (mp_on set before the first allocation) every block carries a small
+    header with its size and subsystem, so frees are charged back and the
+    current and peak heap are exact; with it off the calls go straight to
+    the C library.  Counters are plain: only one thread allocates.
+    MP_FRAME(site) records how much stack is in use inside a function,
+    measured from the top of the stack of the thread it runs on (found by
+    mp_stack_begin(); this includes the few frames of the CRT startup).
+    Peak RSS comes from the OS and also covers what the wrapper cannot
+    see: the CRT, stdio buffers and thread stacks.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#ifdef __linux__
+/* pthread_getattr_np is a GNU extension: a file that includes this
+   defines _GNU_SOURCE before its first #include */
+#ifndef _GNU_SOURCE
+#error "define _GNU_SOURCE before the first #include (memprof.h)"
+#endif
+#include <pthread.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define MP_TLS __declspec(thread)
+#define MP_NOINLINE __declspec(noinline)
+#else
+#define MP_TLS __thread
+#define MP_NOINLINE __attribute__((noinline, unused))  /* unused: not every file calls them */
+#endif
+
+enum { MP_LEXER, MP_PARSER, MP_OUTPUT, MP_NSUB };
+
+/* stack probe sites, one per instrumented function */
+enum {
+    MP_F_LEXER_MAIN, MP_F_LEX_LINE, MP_F_PARSER_MAIN, MP_F_VALIDATE_LINE,
+    MP_F_SEM_LINE, MP_F_PIPE_LEXER, MP_F_PIPE_PARSER, MP_NFRAMES
+};
+
+static const char *const mp_sub_name[MP_NSUB] = { "lexer", "parser", "output" };
+static const char *const mp_frame_name[MP_NFRAMES] = {
+    "project_lexer main", "lex_line", "project_parser main", "validate_line",
+    "sem_line", "pipe_lexer_main", "pipeline_parse"
+};
+
+typedef struct {
+    long allocs, reallocs, frees;
+    long long requested;            /* bytes asked for, over the whole run */
+    long long cur, peak;
+} mp_stats;
+
+typedef union {
+    struct {
+        size_t size;
+        int sub;
+    } h;
+    char align[16];                 /* keeps the block behind it 16-byte aligned */
+} mp_header;
+
+static int mp_on;
+static mp_stats mp_sub[MP_NSUB];
+static long long mp_cur, mp_peak;
+static long mp_frame_depth[MP_NFRAMES];
+static MP_TLS size_t mp_stack_top;    /* address, kept as a number */
+
+static inline void mp_charge(int sub, long long delta)
+{
+    mp_sub[sub].cur += delta;
+    if (mp_sub[sub].cur > mp_sub[sub].peak) mp_sub[sub].peak = mp_sub[sub].cur;
+    mp_cur += delta;
+    if (mp_cur > mp_peak) mp_peak = mp_cur;
+}
+
+static inline void *mp_malloc(int sub, size_t n)
+{
+    mp_header *h;
+    if (!mp_on) return malloc(n);
+    h = (mp_header *)malloc(sizeof(mp_header) + n);
+    if (!h) return NULL;
+    h->h.size = n;
+    h->h.sub = sub;
+    mp_sub[sub].allocs++;
+    mp_sub[sub].requested += n;
+    mp_charge(sub, (long long)n);
+    return h + 1;
+}
+
+static inline void *mp_realloc(int sub, void *p, size_t n)
+{
+    mp_header *h;
+    size_t old;
+    if (!mp_on) return realloc(p, n);
+    if (!p) return mp_malloc(sub, n);
+    h = (mp_header *)p - 1;
+    old = h->h.size;
+    sub = h->h.sub;
+    h = (mp_header *)realloc(h, sizeof(mp_header) + n);
+    if (!h) return NULL;
+    h->h.size = n;
+    mp_sub[sub].reallocs++;
+    if (n > old) mp_sub[sub].requested += n - old;
+    mp_charge(sub, (long long)n - (long long)old);
+    return h + 1;
+}
+
+static inline void mp_free(void *p)
+{
+    mp_header *h;
+    if (!mp_on) {
+        free(p);
+        return;
+    }
+    if (!p) return;
+    h = (mp_header *)p - 1;
+    mp_sub[h->h.sub].frees++;
+    mp_charge(h->h.sub, -(long long)h->h.size);
+    free(h);
+}
+
+/* call at the top of main and of every thread function */
+static MP_NOINLINE void mp_stack_begin(void)
+{
+    char here;
+#if defined(_WIN32)
+    ULONG_PTR low, high;
+    GetCurrentThreadStackLimits(&low, &high);
+    mp_stack_top = (size_t)high;
+#elif defined(__linux__)
+    pthread_attr_t attr;
+    void *addr;
+    size_t size;
+    mp_stack_top = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+            mp_stack_top = (size_t)addr + size;
+        pthread_attr_destroy(&attr);
+    }
+#else
+    mp_stack_top = 0;
+#endif
+    /* no OS answer: count from here, which misses the caller's frame */
+    if (!mp_stack_top) mp_stack_top = (size_t)&here;
+}
+
+/* not inlined, so its local sits below the whole frame of the caller */
+static MP_NOINLINE void mp_frame_probe(int site)
+{
+    char here;
+    long depth;
+    if (!mp_stack_top) return;
+    depth = (long)(mp_stack_top - (size_t)&here);
+    if (depth > mp_frame_depth[site]) mp_frame_depth[site] = depth;
+}
+
+#define MP_FRAME(site) do { if (mp_on) mp_frame_probe(site); } while (0)
+
+static inline long long mp_peak_rss(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return (long long)pmc.PeakWorkingSetSize;
+    return -1;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+    return (long long)ru.ru_maxrss;
+#else
+    return (long long)ru.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/* peak heap per MB of input; inputs under 1 MB count as 1 MB */
+static inline double mp_kb_per_mb(long long input_bytes)
+{
+    double mb = input_bytes / 1048576.0;
+    if (mb < 1.0) mb = 1.0;
+    return mp_peak / 1024.0 / mb;
+}
+
+static inline void mp_report(FILE *out, long long input_bytes)
+{
+    long long rss = mp_peak_rss();
+    double mb = input_bytes / 1048576.0;
+    int order[MP_NFRAMES];
+    int i, j, t;
+
+    fprintf(out, "\n==== MEMORY PROFILE ====\n");
+    fprintf(out, "input       %10.2f MB\n", mb);
+    if (rss >= 0)
+        fprintf(out, "peak RSS    %10.2f MB\n", rss / 1048576.0);
+    fprintf(out, "peak heap   %10.2f KB  (%.1f KB per MB of input)\n", mp_peak / 1024.0, mp_kb_per_mb(input_bytes));
+    fprintf(out, "\n%-10s %10s %10s %10s %14s %12s\n", "subsystem", "allocs", "reallocs", "frees", "bytes", "peak bytes");
+    for (i = 0; i < MP_NSUB; i++)
+        fprintf(out, "%-10s %10ld %10ld %10ld %14lld %12lld\n", mp_sub_name[i], mp_sub[i].allocs,
+                mp_sub[i].reallocs, mp_sub[i].frees, mp_sub[i].requested, mp_sub[i].peak);
+
+    for (i = 0; i < MP_NFRAMES; i++) order[i] = i;
+    for (i = 1; i < MP_NFRAMES; i++)
+        for (j = i; j > 0 && mp_frame_depth[order[j]] > mp_frame_depth[order[j - 1]]; j--) {
+            t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    fprintf(out, "\nstack in use, deepest point per function (bytes):\n");
+    for (i = 0; i < MP_NFRAMES; i++)
+        if (mp_frame_depth[order[i]] > 0)
+            fprintf(out, "  %-20s %8ld\n", mp_frame_name[order[i]], mp_frame_depth[order[i]]);
+    fprintf(out, "==== END MEMORY PROFILE ====\n");
+}
+
+#endif /* MEMPROF_H */
@@ -0,0 +1,207 @@
+#ifndef PARSER_CORE_H
+#define PARSER_CORE_H
+/* parser_core.h
+   Line checks of project_parser.c, shared with its pipelined mode.
+   validate_line() returns 0 on the first problem and leaves the
+   "Line N: ..." message in parse_diag instead of printing it, so the
+   caller decides which error wins.
+*/
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "lexer_tables.h"
+#include "memprof.h"
+
+#define MAXLINE 1024
+
+static char parse_diag[256];
+
+static inline int parse_fail(const char *fmt, ...){
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(parse_diag, sizeof(parse_diag), fmt, ap);
+    va_end(ap);
+    return 0;
+}
+
+// VAR and FUNC_NAME patterns live in lexer_spec.txt, shared with the lexer
+static inline int is_variable(const char *s){
+    return dfa_classify(&lex_ident_dfa, s, (int)strlen(s)) == LEX_TOK_VAR;
+}
+
+static inline int is_c_identifier(const char *s){
+    if(!s || !s[0]) return 0;
+    if(!(isalpha((unsigned char)s[0]) || s[0]=='_')) return 0;
+    for(int i=1; s[i]; i++) if(!(isalnum((unsigned char)s[i]) || s[i]=='_')) return 0;
+    return 1;
+}
+
+static inline int is_function_name(const char *s){
+    return dfa_classify(&lex_ident_dfa, s, (int)strlen(s)) == LEX_TOK_FUNC_NAME;
+}
+
+// first line as read by fgets; must be the stdio include
+static inline int is_include_first(const char *raw){
+    char line[MAXLINE];
+    strncpy(line, raw, sizeof(line)-1); line[sizeof(line)-1] = 0;
+    line[strcspn(line, "\r\n")] = 0;
+    while(isspace((unsigned char)line[0])) memmove(line, line+1, strlen(line));
+    if(strcmp(line, "#include<stdio.h>")==0 || strcmp(line, "#include <stdio.h>")==0) return 1;
+    return 0;
+}
+
+static inline int line_has_main(const char *line){
+    // naive search for "int main(" or "int main ()" or "int main()"
+    return strstr(line, "main(") || strstr(line, "main (");
+}
+
+// checks one line as read by fgets; line 1 is skipped. The checks run on
+// a copy without the line ending, so raw is left as it was.
+static inline int validate_line(const char *raw, int lineno){
+    MP_FRAME(MP_F_VALIDATE_LINE);
+    if(lineno == 1) return 1;
+    // trim
+    char line[MAXLINE];
+    size_t n = strcspn(raw, "\r\n");
+    if(n >= sizeof(line)) n = sizeof(line) - 1;
+    memcpy(line, raw, n);
+    line[n] = 0;
+    char *p = line;
+    while(*p && isspace((unsigned char)*p)) p++;
+    if(*p == 0) return 1;
+    // comment?
+    if(p[0]=='/' && p[1]=='/'){
+        // ensure only letters and spaces after //
+        p += 2;
+        while(*p){
+            if(!isalpha((unsigned char)*p) && *p!=' ' && *p!='\t')return parse_fail("Line %d: invalid comment characters", lineno);
+            p++;
+        }
+        return 1;
+    }
+    // if this line is a function header (e.g. "int addFn(int _x1a) {"), skip it
+    if ((strncmp(p, "int ", 4) == 0 || strncmp(p, "dec ", 4) == 0) && strchr(p, '(')) {
+        /* ensure this looks like a function header (has '(' before '=' or ';') */
+        char *paren = strchr(p, '(');
+        char *eq = strchr(p, '=');
+        char *semi = strchr(p, ';');
+        if (paren && ((eq == NULL) || (paren < eq)) && ((semi == NULL) || (paren < semi))) {
+            return 1;
+        }
+    }
+
+    // check printf pattern: printf( <var> )..
+    if(strstr(line, "printf(")){
+        char *q = strstr(line, "printf(");
+        q += strlen("printf(");
+        // find next ')'
+        char *r = strchr(q, ')');
+        if(!r)return parse_fail("Line %d: printf missing closing parenthesis", lineno);
+        // extract inside
+        char inside[256]; int len = (int)(r - q);
+        if (len >= (int)sizeof(inside)) len = (int)sizeof(inside)-1;
+        strncpy(inside, q, len); inside[len]=0;
+        // trim
+        char *s = inside; while(*s && isspace((unsigned char)*s)) s++;
+        char *t = inside + strlen(inside) - 1; while(t>=inside && isspace((unsigned char)*t)) *t--=0;
+        // If printf has comma-separated args (C-style), take the last argument as variable
+        if (strchr(s, ',')) {
+            char *last = s + strlen(s) - 1;
+            while(last > s && isspace((unsigned char)*last)) last--;
+            /* move back to char after previous comma */
+            while(last > s && *last != ',') last--;
+            if (*last == ',') last++; /* move to char after comma */
+            while(*last && isspace((unsigned char)*last)) last++;
+            s = last;
+        }
+        /* Accept either a variable or a string literal as printf argument (single-arg printf) */
+        if(!(s[0] == '"' || is_variable(s)))return parse_fail("Line %d: printf argument not valid variable '%s'", lineno, s);
+        // check terminator ".." or C-style ";" somewhere after r
+        if(strstr(r, "..")==NULL && strstr(r, ";")==NULL){ return parse_fail("Line %d: statement missing '..' or ';' terminator", lineno); }
+        return 1;
+    }
+    // check variable declarations like: dec _input3k = 10..
+    if(strstr(line, "dec ") || strstr(line, "int ")){
+        // ensure variable name matches and terminator exists
+        /* if this is the function header for main, skip it */
+        if (strstr(line, "main(") || strstr(line, "main (")) return 1;
+
+        char *typ = strstr(line, "dec ") ? strstr(line, "dec ") : strstr(line, "int ");
+        if(typ){
+            char buf[256];
+            strncpy(buf, typ, sizeof(buf)-1); buf[sizeof(buf)-1]=0;
+            // tokenise: type var = value..
+            char type[16], varname[128];
+            if(sscanf(buf, "%15s %127s", type, varname) >= 2){
+                /* varname may contain trailing chars like "= 10.." so extract upto non-var chars (space or '=' or ';' or '.') */
+                char vn[128]; int i=0;
+                while (i < (int)strlen(varname) && varname[i] != '=' && varname[i] != ';' && varname[i] != '.' && !isspace((unsigned char)varname[i])) {
+                    vn[i] = varname[i];
+                    i++;
+                }
+                vn[i] = 0;
+                if(!is_variable(vn) && !is_c_identifier(vn))return parse_fail("Line %d: invalid variable name '%s'", lineno, vn);
+                if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ return parse_fail("Line %d: missing '..' or ';' terminator", lineno); }
+            }
+        }
+        return 1;
+    }
+    // check while loop pattern: while (dec _loopin0x < 3..) { 
+    if(strstr(line, "while")){
+        // must contain '(' and ')' and comparator <
+        if(strstr(line, "(") == NULL || strstr(line, ")") == NULL)return parse_fail("Line %d: while parenthesis missing", lineno);
+        if(strstr(line, "<") == NULL)return parse_fail("Line %d: while comparator expected '<'", lineno);
+        /* Allow C-style while with opening brace after the condition: "while (cond) {"
+           In that case don't require DSL terminator '..' or ';' in the same line. */
+        {
+            char *rp = strchr(line, ')');
+            if (rp) {
+                char *brace_after = strchr(rp, '{');
+                if (brace_after == NULL && strstr(line, "..") == NULL && strstr(line, ";") == NULL) {
+                    return parse_fail("Line %d: while condition missing '..' or ';'", lineno);
+                }
+            }
+        }
+        /* Scan the original line for a variable token that matches is_variable pattern */
+        {
+            int found = 0;
+            int llen = (int)strlen(line);
+            int si;
+            for(si = 0; si < llen; si++){
+                if(line[si] == '_'){
+                    /* extract token of alnum/_ chars starting at si */
+                    int sj = si;
+                    char cand[128]; int ck = 0;
+                    while(sj < llen && (isalnum((unsigned char)line[sj]) || line[sj] == '_')){
+                        if(ck < (int)sizeof(cand)-1) cand[ck++] = line[sj];
+                        sj++;
+                    }
+                    cand[ck] = 0;
+                    if(ck > 0 && (is_variable(cand) || is_c_identifier(cand))){
+                        found = 1;
+                        break;
+                    }
+                }
+            }
+            if(!found)return parse_fail("Line %d: while variable not found", lineno);
+        }
+        return 1;
+    }
+
+    // check return statement like return 0..
+    if(strstr(line, "return")){
+        if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ return parse_fail("Line %d: return missing '..' or ';'", lineno); }
+        return 1;
+    }
+
+    // if open brace or close brace or break with terminator
+    if(strstr(line, "break")){
+        if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ return parse_fail("Line %d: break missing '..' or ';'", lineno); }
+        return 1;
+    }
+    return 1;
+}
+
+#endif /* PARSER_CORE_H */
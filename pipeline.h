@@ -0,0 +1,197 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+/* pipeline.h
+   Pipelined lexer -> parser run (project_parser.exe --pipeline)
+   The same per-line work as the sequential run (pipe_lex + pipe_check),
+   split over two threads: a lexer thread reads the source through
+   text_input.h (so UTF-16 and BOM files read as in the other modes), lexes each
+   line with lexer_core.h and pushes batches of the lines and their
+   tokens through an SPSC ring; the calling thread runs the parser_core.h
+   line checks on them as they arrive.  The line checks look at the text;
+   the semantic pass (semantic.h), when a sem_state is passed, works from
+   the lexer's tokens (sem_line_tokens) instead of splitting the line
+   again.  The overlap is only for speed: the sequential run does the
+   same pipe_lex + pipe_check per line and gets the same result.
+   Batches come from a fixed pool and go back to the lexer through a
+   second ring, so memory stays at PIPE_BATCHES batches however large
+   the input is.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexer_core.h"
+#include "parser_core.h"
+#include "semantic.h"
+#include "spsc_queue.h"
+#include "text_input.h"
+
+#define PIPE_BATCHES 8
+#define PIPE_BATCH_BYTES (32 * 1024)
+#define PIPE_BATCH_LINES 1024
+#define PIPE_BATCH_TOKENS 6144      /* a line has at most one token per byte */
+
+typedef struct {
+    int nlines;
+    int used;
+    int ntok;
+    int last;                       /* no more batches after this one */
+    int off[PIPE_BATCH_LINES];      /* start of each line in text */
+    int first[PIPE_BATCH_LINES + 1];/* its tokens: tok[first[i] .. first[i + 1]) */
+    sm_pos pos[PIPE_BATCH_LINES];   /* and in the decoded source */
+    lex_tok tok[PIPE_BATCH_TOKENS]; /* spans in the line's text */
+    char text[PIPE_BATCH_BYTES];    /* lines from ti_getline, NUL separated */
+} pipe_batch;
+
+typedef struct {
+    const char *input_err;          /* the input could not be read or decoded */
+    int input_line;                 /* where (0: before the first line) */
+    int lex_ok;
+    char lex_err[128];
+    long tokens;
+    int include_ok;
+    int has_main;
+    int structure_ok;
+    char diag[256];
+} pipe_result;
+
+typedef struct {
+    FILE *f;
+    spsc_queue full;                /* lexer -> parser */
+    spsc_queue free;                /* parser -> lexer */
+    pipe_result *r;
+} pipe_ctx;
+
+static inline void pipe_count_token(void *ctx, const char *tok, const char *lex)
+{
+    (void)tok;
+    (void)lex;
+    ((pipe_result *)ctx)->tokens++;
+}
+
+static inline void pipe_result_init(pipe_result *r)
+{
+    memset(r, 0, sizeof(*r));
+    r->lex_ok = 1;
+    r->structure_ok = 1;
+}
+
+/* Lexer side of one line: after the first lexer error the rest of the
+   input is not lexed, as in project_lexer.  The tokens go to ls->tok
+   (ls->ntok of them, none once lexing has stopped). */
+static inline void pipe_lex(lex_state *ls, pipe_result *r, const char *line, int lineno)
+{
+    char tmp[MAXLINE];
+    ls->ntok = 0;
+    if (!r->lex_ok) return;
+    strcpy(tmp, line);
+    tmp[strcspn(tmp, "\r\n")] = 0;
+    if (!lex_line(ls, tmp, lineno)) {
+        r->lex_ok = 0;
+        strcpy(r->lex_err, ls->err);
+    }
+}
+
+/* Parser side of one line and its ntok tokens from pipe_lex; pos is
+   where the line starts in the source. */
+static inline void pipe_check(pipe_result *r, sem_state *sem, const char *line, int lineno,
+                              sm_pos pos, const lex_tok *tok, int ntok)
+{
+    if (lineno == 1) r->include_ok = is_include_first(line);
+    if (!r->has_main && line_has_main(line)) r->has_main = 1;
+    if (r->structure_ok && !validate_line(line, lineno)) {
+        r->structure_ok = 0;
+        strcpy(r->diag, parse_diag);
+    }
+    if (sem) sem_line_tokens(sem, line, pos, tok, ntok);
+}
+
+static inline THREAD_RET THREAD_CALL pipe_lexer_main(void *arg)
+{
+    pipe_ctx *pc = (pipe_ctx *)arg;
+    ti_reader tr;
+    char *line;
+    lex_state ls;
+    pipe_batch *b;
+    int lineno = 0, len;
+    char *text;
+
+    mp_stack_begin();
+    MP_FRAME(MP_F_PIPE_LEXER);
+    lex_init(&ls, pipe_count_token, pc->r);
+    b = (pipe_batch *)spsc_pop(&pc->free);
+    b->nlines = b->used = b->ntok = b->last = 0;
+    if (!ti_open(&tr, pc->f)) {
+        pc->r->input_err = "out of memory";
+        ti_close(&tr);
+        b->last = 1;
+        spsc_push(&pc->full, b);
+        return THREAD_RESULT;
+    }
+    while ((line = ti_getline(&tr, MAXLINE)) != NULL) {
+        len = (int)strlen(line) + 1;
+        if (b->nlines == PIPE_BATCH_LINES || b->used + len > PIPE_BATCH_BYTES ||
+            b->ntok + len > PIPE_BATCH_TOKENS) {
+            spsc_push(&pc->full, b);
+            b = (pipe_batch *)spsc_pop(&pc->free);
+            b->nlines = b->used = b->ntok = b->last = 0;
+        }
+        text = b->text + b->used;
+        memcpy(text, line, len);
+        b->pos[b->nlines] = (sm_pos)ti_offset(&tr, line);
+        b->off[b->nlines] = b->used;
+        b->first[b->nlines] = b->ntok;
+        b->used += len;
+        ls.tok = b->tok + b->ntok;
+        pipe_lex(&ls, pc->r, text, ++lineno);
+        b->ntok += ls.ntok;
+        b->first[++b->nlines] = b->ntok;
+    }
+    if (tr.err) {
+        pc->r->input_err = tr.err;
+        pc->r->input_line = lineno + 1;
+    }
+    ti_close(&tr);
+    b->last = 1;
+    spsc_push(&pc->full, b);
+    return THREAD_RESULT;
+}
+
+/* Returns -1 if the lexer thread could not be started.  sem may be NULL;
+   otherwise it must be sem_init'ed and the caller runs sem_finish. */
+static inline int pipeline_parse(FILE *f, pipe_result *r, sem_state *sem)
+{
+    pipe_ctx pc;
+    pipe_batch *pool, *b;
+    thread_t lexer;
+    int i, lineno = 0, last;
+
+    MP_FRAME(MP_F_PIPE_PARSER);
+    pipe_result_init(r);
+    pool = (pipe_batch *)mp_malloc(MP_LEXER, PIPE_BATCHES * sizeof(pipe_batch));
+    if (!pool) return -1;
+    pc.f = f;
+    pc.r = r;
+    spsc_init(&pc.full);
+    spsc_init(&pc.free);
+    for (i = 0; i < PIPE_BATCHES; i++) spsc_push(&pc.free, &pool[i]);
+
+    if (thread_start(&lexer, pipe_lexer_main, &pc) != 0) {
+        mp_free(pool);
+        return -1;
+    }
+    do {
+        b = (pipe_batch *)spsc_pop(&pc.full);
+        for (i = 0; i < b->nlines; i++) {
+            pipe_check(r, sem, b->text + b->off[i], ++lineno, b->pos[i],
+                       b->tok + b->first[i], b->first[i + 1] - b->first[i]);
+        }
+        last = b->last;
+        spsc_push(&pc.free, b);
+    } while (!last);
+    thread_join(lexer);
+    mp_free(pool);
+    return 0;
+}
+
+#endif /* PIPELINE_H */
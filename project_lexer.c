@@ -3,332 +3,223 @@
 /* project_lexer.c
     MSVC-compatible C89 version
     Validates custom language syntax and produces token stream
+    Character classes and word rules come from lexer_tables.h, which
+    lexgen.exe generates from lexer_spec.txt at build time; the per-line
+    scanner itself lives in lexer_core.h.
+    Input goes through text_input.h: UTF-16 files (BOM) are transcoded
+    to UTF-8 and UTF-8 is validated before it reaches the lexer.
+    --mem-profile prints heap, RSS and stack use to stderr (memprof.h);
+    --mem-limit N also exits with 3 if the peak heap goes past N KB per
+    MB of input (run_all_tests.bat uses it as a regression check).
+    Given several files it lexes each in turn and prints one summary line
+    per file instead of the tokens (batch mode); batch_io.h reads the
+    files ahead, in parallel, into a reused pool of buffers.
 */
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np (memprof.h), syscall and pread (batch_io.h) */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+
+#include "batch_io.h"
+#include "lexer_core.h"
+#include "text_input.h"
 
 #define MAXLINE 1024
-#define MAXTOK 1024
+#define MAXNAMES 256
 
-int is_variable(const char *s)
-{
-    int n, i;
-    n = strlen(s);
-    if (n < 4) return 0;
-    if (s[0] != '_') return 0;
-    i = 1;
-    if (!isalpha(s[i])) return 0;
-    while (i < n && isalpha(s[i])) i++;
-    if (i >= n || !isdigit(s[i])) return 0;
-    i++;
-    if (i >= n || !isalpha(s[i])) return 0;
-    i++;
-    return i == n;
-}
+/* The token stream printed at the end keeps one byte per token: an index
+   into the distinct token names seen (a few keywords plus SYM(x) for
+   each symbol), so it grows with the input instead of sitting in a fixed
+   MAXTOK x 256 byte array. */
+static char tok_names[MAXNAMES][16];
+static int ntok_names;
+static unsigned char *stream;
+static long stream_len, stream_cap;
 
-int is_function_name(const char *s)
+void emit(const char *tok, const char *lex)
 {
-    int n, len, i;
-    n = strlen(s);
-    if (n < 3) return 0;
-    len = n - 2;
-    if (strcmp(s + len, "Fn") != 0) return 0;
-    for (i = 0; i < len; i++)
-        if (!isalpha(s[i])) return 0;
-    return 1;
+    if (lex)
+        printf("%-20s : %s\n", tok, lex);
+    else
+        printf("%s\n", tok);
 }
 
-int is_include_line(const char *s)
+static int token_name_index(const char *tok)
 {
-    char tmp[MAXLINE];
-    int n;
-    strcpy(tmp, s);
-    while (*tmp && isspace((unsigned char)*tmp))
-        memmove(tmp, tmp + 1, strlen(tmp));
-    n = strlen(tmp);
-    while (n > 0 && isspace((unsigned char)tmp[n - 1]))
-        tmp[--n] = 0;
-    return strcmp(tmp, "#include<stdio.h>") == 0 || 
-           strcmp(tmp, "#include <stdio.h>") == 0;
+    int i;
+    for (i = 0; i < ntok_names; i++)
+        if (strcmp(tok_names[i], tok) == 0) return i;
+    if (ntok_names == MAXNAMES) return MAXNAMES - 1;
+    strncpy(tok_names[ntok_names], tok, sizeof(tok_names[0]) - 1);
+    return ntok_names++;
 }
 
-int is_comment_line(const char *s)
+static void emit_token(void *ctx, const char *tok, const char *lex)
 {
-    const char *p;
-    p = s;
-    while (*p && isspace((unsigned char)*p)) p++;
-    if (p[0] == '/' && p[1] == '/') {
-        p += 2;
-        while (*p) {
-            if (!(*p == ' ' || isalpha((unsigned char)*p) || isspace((unsigned char)*p)))
-                return 0;
-            p++;
+    (void)ctx;
+    emit(tok, lex);
+    if (stream_len == stream_cap) {
+        stream_cap = stream_cap ? stream_cap * 2 : 4096;
+        stream = (unsigned char *)mp_realloc(MP_OUTPUT, stream, stream_cap);
+        if (!stream) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
         }
-        return 1;
     }
-    return 0;
+    stream[stream_len++] = (unsigned char)token_name_index(tok);
 }
 
-void emit(const char *tok, const char *lex)
+static void count_token(void *ctx, const char *tok, const char *lex)
 {
-    if (lex)
-        printf("%-20s : %s\n", tok, lex);
-    else
-        printf("%s\n", tok);
+    (void)tok;
+    (void)lex;
+    (*(long *)ctx)++;
+}
+
+/* Batch mode: lexes each file from memory and prints its verdict.
+   Returns the number of files that failed. */
+static int lex_batch(char **paths, int n, long *input_bytes)
+{
+    bio_loader ld;
+    bio_file *bf;
+    ti_reader tr;
+    lex_state ls;
+    char *line;
+    long tokens;
+    int lineno, failed;
+
+    failed = 0;
+    bio_open(&ld, (const char *const *)paths, n, BIO_AUTO);
+    while ((bf = bio_next(&ld)) != NULL) {
+        if (bf->err) {
+            printf("%s: cannot read file: %s\n", bf->path, strerror(bf->err));
+            failed++;
+            bio_release(&ld, bf);
+            continue;
+        }
+        *input_bytes += (long)bf->len;
+        if (!ti_open_mem(&tr, bf->data, bf->len)) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+        tokens = 0;
+        lineno = 0;
+        lex_init(&ls, count_token, &tokens);
+        while ((line = ti_getline(&tr, MAXLINE)) != NULL) {
+            lineno++;
+            line[strcspn(line, "\r\n")] = 0;
+            if (!lex_line(&ls, line, lineno)) break;
+        }
+        if (line) {
+            printf("%s: %s\n", bf->path, ls.err);
+            failed++;
+        } else if (tr.err) {
+            printf("%s: Error: %s at line %d\n", bf->path, tr.err, lineno + 1);
+            failed++;
+        } else {
+            printf("%s: OK (%ld tokens)\n", bf->path, tokens);
+        }
+        ti_close(&tr);
+        bio_release(&ld, bf);
+    }
+    bio_close(&ld);
+    printf("\n==== %d files, %d passed, %d failed ====\n", n, n - failed, failed);
+    return failed;
 }
 
 int main(int argc, char **argv)
 {
     FILE *f;
-    char line[MAXLINE];
-    char tmp[1024];
-    char id[256];
-    char buf[256];
-    char num[64];
-    char tmp2[16];
-    char *s;
-    char *ptrim;
-    int lineno, ok, saw_main, tokc;
-    int allspace, i, j, oklabel, letters;
-    char tokens[MAXTOK][256];
-
-    if (argc < 2) {
-        printf("Usage: %s <source-file>\n", argv[0]);
+    char *line;
+    ti_reader tr;
+    lex_state ls;
+    int lineno, ok, argi, profile, limit, rc;
+    long i, input_bytes;
+
+    mp_stack_begin();
+    profile = 0;
+    limit = 0;
+    for (argi = 1; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--mem-profile") == 0) {
+            profile = 1;
+        } else if (strcmp(argv[argi], "--mem-limit") == 0 && argi + 1 < argc) {
+            profile = 1;
+            limit = atoi(argv[++argi]);
+        } else {
+            break;
+        }
+    }
+    if (argi >= argc) {
+        printf("Usage: %s [--mem-profile] [--mem-limit KB-per-MB] <source-file>...\n", argv[0]);
         return 1;
     }
+    mp_on = profile;
+    MP_FRAME(MP_F_LEXER_MAIN);
 
-    f = fopen(argv[1], "r");
+    if (argc - argi > 1) {
+        input_bytes = 0;
+        rc = lex_batch(argv + argi, argc - argi, &input_bytes) ? 1 : 0;
+        goto report;
+    }
+
+    f = fopen(argv[argi], "rb");
     if (!f) {
         perror("fopen");
         return 1;
     }
+    fseek(f, 0, SEEK_END);
+    input_bytes = ftell(f);
+    rewind(f);
+    if (!ti_open(&tr, f)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
 
     lineno = 0;
     ok = 1;
-    saw_main = 0;
-    tokc = 0;
+    lex_init(&ls, emit_token, NULL);
 
-    while (fgets(line, sizeof(line), f)) {
+    while ((line = ti_getline(&tr, MAXLINE)) != NULL) {
         lineno++;
         line[strcspn(line, "\r\n")] = 0;
-
-        if (lineno == 1) {
-            if (!is_include_line(line)) {
-                printf("Error: first line must be #include<stdio.h>\n");
-                ok = 0;
-                break;
-            }
-            emit("INCLUDE", "#include<stdio.h>");
-            strcpy(tokens[tokc++], "INCLUDE");
-            continue;
-        }
-
-        strcpy(tmp, line);
-        allspace = 1;
-        for (i = 0; i < (int)strlen(tmp); i++) {
-            if (!isspace((unsigned char)tmp[i])) {
-                allspace = 0;
-                break;
-            }
-        }
-        if (allspace) continue;
-
-        ptrim = tmp;
-        while (*ptrim && isspace((unsigned char)*ptrim)) ptrim++;
-        /* allow other preprocessor/include lines after first line (e.g. #include <string.h>) */
-        if (ptrim[0] == '#') {
-            /* emit the whole trimmed line as INCLUDE */
-            emit("INCLUDE", ptrim);
-            strcpy(tokens[tokc++], "INCLUDE");
-            continue;
-        }
-        if (ptrim[0] == '/' && ptrim[1] == '/') {
-            if (!is_comment_line(ptrim)) {
-                printf("Error: invalid comment at line %d\n", lineno);
-                ok = 0;
-                break;
-            }
-            emit("COMMENT", ptrim + 2);
-            strcpy(tokens[tokc++], "COMMENT");
-            continue;
-        }
-
-        s = tmp;
-        while (*s) {
-            if (isspace((unsigned char)*s)) {
-                s++;
-                continue;
-            }
-
-            if (strncmp(s, "loop_", 5) == 0) {
-                i = 0;
-                while (s[i] && !isspace((unsigned char)s[i]) && s[i] != '{' && s[i] != '(') {
-                    buf[i] = s[i];
-                    i++;
-                }
-                buf[i] = 0;
-                if (buf[strlen(buf) - 1] == ':') {
-                    oklabel = 1;
-                    j = 5;
-                    letters = 0;
-                    while (buf[j] && isalpha((unsigned char)buf[j])) {
-                        letters++;
-                        j++;
-                    }
-                    if (letters < 1) oklabel = 0;
-                    if (!(isdigit((unsigned char)buf[j]) && isdigit((unsigned char)buf[j + 1]) &&
-                          buf[j + 2] == ':'))
-                        oklabel = 0;
-                    if (!oklabel) {
-                        printf("Error: invalid loop label at line %d\n", lineno);
-                        ok = 0;
-                        break;
-                    }
-                    emit("LOOP_LABEL", buf);
-                    strcpy(tokens[tokc++], "LOOP_LABEL");
-                    s += i;
-                    continue;
-                }
-            }
-
-            if (isalpha((unsigned char)*s) || *s == '_') {
-                i = 0;
-                while (s[i] && (isalnum((unsigned char)s[i]) || s[i] == '_')) {
-                    id[i] = s[i];
-                    i++;
-                }
-                id[i] = 0;
-                if (strcmp(id, "int") == 0 || strcmp(id, "dec") == 0) {
-                    emit("TYPE", id);
-                    strcpy(tokens[tokc++], "TYPE");
-                } else if (strcmp(id, "while") == 0) {
-                    emit("WHILE", "while");
-                    strcpy(tokens[tokc++], "WHILE");
-                } else if (strcmp(id, "printf") == 0) {
-                    emit("PRINTF", "printf");
-                    strcpy(tokens[tokc++], "PRINTF");
-                } else if (strcmp(id, "return") == 0) {
-                    emit("RETURN", "return");
-                    strcpy(tokens[tokc++], "RETURN");
-                } else if (strcmp(id, "break") == 0) {
-                    emit("BREAK", "break");
-                    strcpy(tokens[tokc++], "BREAK");
-                } else if (is_function_name(id)) {
-                    emit("FUNC_NAME", id);
-                    strcpy(tokens[tokc++], "FUNC_NAME");
-                } else if (is_variable(id)) {
-                    emit("VAR", id);
-                    strcpy(tokens[tokc++], "VAR");
-                } else if (strcmp(id, "main") == 0) {
-                    emit("MAIN", "main");
-                    strcpy(tokens[tokc++], "MAIN");
-                    saw_main = 1;
-                } else {
-                    emit("IDENT", id);
-                    strcpy(tokens[tokc++], "IDENT");
-                }
-                s += i;
-                continue;
-            }
-
-            if (isdigit((unsigned char)*s)) {
-                i = 0;
-                while (isdigit((unsigned char)s[i])) {
-                    num[i] = s[i];
-                    i++;
-                }
-                num[i] = 0;
-                emit("NUM", num);
-                strcpy(tokens[tokc++], "NUM");
-                s += i;
-                continue;
-            }
-
-            if (s[0] == '.' && s[1] == '.') {
-                emit("STMT_END", "..");
-                strcpy(tokens[tokc++], "STMT_END");
-                s += 2;
-                continue;
-            }
-
-            /* handle C-style string literals ("...") by capturing them as STRING tokens */
-            if (s[0] == '"') {
-                int si = 0;
-                char strlit[512];
-                s++; /* skip opening quote */
-                while (*s) {
-                    if (*s == '\\' && s[1]) {
-                        /* keep escaped char */
-                        if (si < (int)sizeof(strlit)-2) {
-                            strlit[si++] = *s;
-                            strlit[si++] = s[1];
-                        }
-                        s += 2;
-                        continue;
-                    }
-                    if (*s == '"') { s++; break; }
-                    if (si < (int)sizeof(strlit)-1) strlit[si++] = *s;
-                    s++;
-                }
-                strlit[si] = 0;
-                emit("STRING", strlit);
-                strcpy(tokens[tokc++], "STRING");
-                continue;
-            }
-
-            /* handle C-style character literals ('a' or '\n') */
-            if (s[0] == '\'') {
-                int si = 0;
-                char charlit[16];
-                s++; /* skip opening quote */
-                if (*s == '\\' && s[1]) {
-                    /* escaped char */
-                    charlit[si++] = *s; charlit[si++] = s[1]; s += 2;
-                } else if (*s) {
-                    charlit[si++] = *s; s++;
-                }
-                /* skip closing quote if present */
-                if (*s == '\'') s++;
-                charlit[si] = 0;
-                emit("CHAR", charlit);
-                strcpy(tokens[tokc++], "CHAR");
-                continue;
-            }
-
-            /* accept additional C operators/symbols: ? | [ ] and keep existing ones */
-            if (strchr("(){}=,+-*/<>;:,?[]|", *s)) {
-                snprintf(tmp2, sizeof(tmp2), "SYM(%c)", *s);
-                emit(tmp2, NULL);
-                strcpy(tokens[tokc++], tmp2);
-                s++;
-                continue;
-            }
-
-            printf("Error: invalid character '%c' at line %d\n", *s, lineno);
+        if (!lex_line(&ls, line, lineno)) {
+            printf("%s\n", ls.err);
             ok = 0;
             break;
         }
-
-        if (!ok) break;
     }
+    if (ok && tr.err) {
+        printf("Error: %s at line %d\n", tr.err, lineno + 1);
+        ok = 0;
+    }
+    ti_close(&tr);
+    fclose(f);
 
     if (!ok) {
         printf("Lexical analysis failed.\n");
-        fclose(f);
-        return 1;
+        rc = 1;
+    } else {
+        printf("\n==== TOKEN STREAM ====\n");
+        for (i = 0; i < stream_len; i++) {
+            printf("%s ", tok_names[stream[i]]);
+            if ((i + 1) % 10 == 0) printf("\n");
+        }
+        printf("\n==== END TOKEN STREAM ====\n");
+        rc = 0;
     }
-
-    printf("\n==== TOKEN STREAM ====\n");
-    for (i = 0; i < tokc; i++) {
-        printf("%s ", tokens[i]);
-        if ((i + 1) % 10 == 0) printf("\n");
+    mp_free(stream);
+
+report:
+    if (profile) {
+        fflush(stdout);
+        mp_report(stderr, input_bytes);
+        if (limit > 0 && mp_kb_per_mb(input_bytes) > limit) {
+            fprintf(stderr, "MEMORY LIMIT EXCEEDED: %.1f KB per MB of input (limit %d)\n",
+                    mp_kb_per_mb(input_bytes), limit);
+            rc = 3;
+        }
     }
-    printf("\n==== END TOKEN STREAM ====\n");
-
-    fclose(f);
-    return 0;
+    return rc;
 }
 
 #endif /* PROJECT_LEXER_C */
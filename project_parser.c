@@ -6,240 +6,212 @@
    - verifies statements end with STMT_END (..)
    - verifies printf and while patterns in a simplified way
    - outputs ACCEPTED or REJECTED
-   Note: uses the token textual output of project_lexer (or re-reads source and re-tokenizes)
+   Every line goes through the lexer (lexer_core.h) as well as the line
+   checks, and a lexer error rejects the program before anything else.
+   With --pipeline the lexer and the checks run on two threads
+   (pipeline.h); that only overlaps the work, the verdict is the same.
+   Accepted structure then goes through the semantic pass (semantic.h),
+   which works from the lexer's tokens: undeclared, duplicate and
+   type-mismatched names reject the program, and so do the control-flow
+   checks (flow.h): break/continue outside a loop, bad break labels,
+   variables read before they are assigned.
+   --mem-profile / --mem-limit work as in project_lexer.c (memprof.h).
+   Every mode reads through text_input.h like project_lexer, so UTF-16
+   and BOM files are checked as their UTF-8 text.
+   Given several files it checks each in turn (batch mode): batch_io.h
+   reads them ahead in parallel, and each is checked in one pass over
+   its text in memory, with the same lexer, line and semantic checks
+   as a single file.  --pipeline is for one file only.
 */
+#define _GNU_SOURCE                 /* glibc: pthread_getattr_np (memprof.h), syscall and pread (batch_io.h) */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
-#define MAXLINE 1024
+#include "batch_io.h"
+#include "parser_core.h"
+#include "pipeline.h"
+#include "semantic.h"
+#include "text_input.h"
 
-// We'll reuse simplified tokenization for validator so you can run parser alone with same source
-// For reliability, parser will just scan file and check higher-level structure.
-
-int is_variable(const char *s){
-    int n = strlen(s);
-    if(n < 4) return 0;
-    if(s[0] != '_') return 0;
-    int i = 1;
-    if(!isalpha((unsigned char)s[i])) return 0;
-    while(i < n && isalpha((unsigned char)s[i])) i++;
-    if(i >= n || !isdigit((unsigned char)s[i])) return 0;
-    i++;
-    if(i >= n || !isalpha((unsigned char)s[i])) return 0;
-    i++;
-    if(i != n) return 0;
-    return 1;
+// builds m over the source as text_input.h decodes it, so the offsets
+// match the ones the pass gave sem_line_tokens: from f, or when f is
+// NULL from data[0..len) (batch mode; the pass has left it as it was read)
+int map_source(sm_map *m, FILE *f, char *data, size_t len){
+    ti_reader tr;
+    const char *p;
+    size_t n;
+    int ok;
+    if(f){ rewind(f); ok = ti_open(&tr, f); }
+    else ok = ti_open_mem(&tr, data, len);
+    ok = ok && sm_add_text(m, NULL, "", 0) != SM_NONE;
+    while(ok && (p = ti_getblock(&tr, &n)) != NULL) ok = sm_extend(m, p, n, (sm_pos)ti_offset(&tr, p));
+    ti_close(&tr);
+    return ok;
 }
 
-int is_c_identifier(const char *s){
-    if(!s || !s[0]) return 0;
-    if(!(isalpha((unsigned char)s[0]) || s[0]=='_')) return 0;
-    for(int i=1; s[i]; i++) if(!(isalnum((unsigned char)s[i]) || s[i]=='_')) return 0;
+// prints the semantic pass messages; returns 1 if there were no errors
+// (warnings are printed but accept).
+// Positions are placed with a sparse map over the source, built only
+// when there is something to report and holding just the lines the
+// messages point at, so it costs the same however long the file is.
+int report_semantics(sem_state *s, FILE *f, char *data, size_t len){
+    int errors = sem_finish(s), total = errors + s->warnings;
+    sm_pos want[2 * SEM_MAX_DIAG];
+    sm_map m;
+    sm_init_sparse(&m, want, sem_diag_offsets(s, want));
+    if(total) map_source(&m, f, data, len);
+    sem_print_diag(s, &m, stdout);
+    sm_free(&m);
+    if(total > s->ndiag) printf("... and %d more semantic messages\n", total - s->ndiag);
+    sem_free(s);
+    if(errors){ printf("PARSE ERROR: semantic analysis failed\n"); return 0; }
     return 1;
 }
 
-int is_function_name(const char *s){
-    int n = strlen(s);
-    if(n < 3) return 0;
-    int len = n - 2;
-    if(strcmp(s + len, "Fn") != 0) return 0;
-    for(int i=0;i<len;i++) if(!isalpha((unsigned char)s[i])) return 0;
-    return 1;
+// prints the verdict for a pass that filled r and s (any mode); the
+// source is f, or data[0..len) when f is NULL
+int report_result(pipe_result *r, sem_state *s, FILE *f, char *data, size_t len){
+    // the rest of the file was never seen, so there is no verdict on it
+    if(r->input_err){
+        if(r->input_line) printf("PARSE ERROR: %s at line %d\n", r->input_err, r->input_line);
+        else printf("PARSE ERROR: %s\n", r->input_err);
+        sem_free(s);
+        return 1;
+    }
+    if(!r->lex_ok){
+        printf("%s\n", r->lex_err);
+        printf("PARSE ERROR: lexical analysis failed\n");
+        sem_free(s);
+        return 1;
+    }
+    if(!r->include_ok){ printf("PARSE ERROR: first line must be #include<stdio.h>\n"); sem_free(s); return 1; }
+    if(!r->has_main){ printf("PARSE ERROR: main function not found\n"); sem_free(s); return 1; }
+    if(!r->structure_ok){
+        printf("%s\n", r->diag);
+        printf("PARSE ERROR: structure validation failed\n");
+        sem_free(s);
+        return 1;
+    }
+    if(!report_semantics(s, f, data, len)) return 1;
+    printf("PARSE SUCCESS: Program ACCEPTED\n");
+    return 0;
 }
 
-int check_include_first(FILE *f){
-    char line[MAXLINE];
-    if(!fgets(line, sizeof(line), f)) return 0;
-    line[strcspn(line, "\r\n")] = 0;
-    while(isspace((unsigned char)line[0])) memmove(line, line+1, strlen(line));
-    if(strcmp(line, "#include<stdio.h>")==0 || strcmp(line, "#include <stdio.h>")==0) return 1;
-    return 0;
+int run_pipeline(FILE *f){
+    pipe_result r;
+    sem_state s;
+    sem_init(&s);
+    if(pipeline_parse(f, &r, &s) != 0){ printf("PARSE ERROR: could not start lexer thread\n"); sem_free(&s); return 1; }
+    return report_result(&r, &s, f, NULL, 0);
 }
 
-int has_main_function(FILE *f){
-    // naive search for "int main(" or "int main ()" or "int main()"
-    char line[MAXLINE];
-    rewind(f);
-    while(fgets(line, sizeof(line), f)){
-        if(strstr(line, "main(") || strstr(line, "main (")) return 1;
+// one pass over the file: each line is lexed, checked and given to the
+// semantic pass, the same work run_pipeline splits over two threads
+int run_sequential(FILE *f){
+    char *line;
+    int lineno = 0;
+    pipe_result r;
+    sem_state s;
+    lex_state ls;
+    lex_tok tok[MAXLINE];
+    ti_reader tr;
+    pipe_result_init(&r);
+    if(!ti_open(&tr, f)){ printf("PARSE ERROR: out of memory\n"); ti_close(&tr); return 1; }
+    lex_init(&ls, pipe_count_token, &r);
+    ls.tok = tok;
+    sem_init(&s);
+    while((line = ti_getline(&tr, MAXLINE)) != NULL){
+        sm_pos pos = (sm_pos)ti_offset(&tr, line);
+        pipe_lex(&ls, &r, line, ++lineno);
+        pipe_check(&r, &s, line, lineno, pos, tok, ls.ntok);
     }
-    return 0;
+    if(tr.err){ r.input_err = tr.err; r.input_line = lineno + 1; }
+    ti_close(&tr);
+    return report_result(&r, &s, f, NULL, 0);
 }
 
-int validate_structure(FILE *f){
-    rewind(f);
-    char line[MAXLINE];
+// batch mode: the same checks as run_sequential in one pass over a file in memory
+int run_memory(char *data, size_t len){
+    pipe_result r;
+    sem_state s;
+    lex_state ls;
+    lex_tok tok[MAXLINE];
+    ti_reader tr;
+    char *line;
     int lineno = 0;
-    int ok = 1;
-    while(fgets(line, sizeof(line), f)){
-        lineno++;
-        // skip first line
-        if(lineno == 1) continue;
-        // trim
-        line[strcspn(line, "\r\n")] = 0;
-        char *p = line;
-        while(*p && isspace((unsigned char)*p)) p++;
-        if(*p == 0) continue;
-        // comment?
-        if(p[0]=='/' && p[1]=='/'){
-            // ensure only letters and spaces after //
-            p += 2;
-            while(*p){
-                if(!isalpha((unsigned char)*p) && *p!=' ' && *p!='\t'){ printf("Line %d: invalid comment characters\n", lineno); return 0; }
-                p++;
-            }
-            continue;
-        }
-        // if this line is a function header (e.g. "int addFn(int _x1a) {"), skip it
-        if ((strncmp(p, "int ", 4) == 0 || strncmp(p, "dec ", 4) == 0) && strchr(p, '(')) {
-            /* ensure this looks like a function header (has '(' before '=' or ';') */
-            char *paren = strchr(p, '(');
-            char *eq = strchr(p, '=');
-            char *semi = strchr(p, ';');
-            if (paren && ((eq == NULL) || (paren < eq)) && ((semi == NULL) || (paren < semi))) {
-                continue;
-            }
-        }
-
-        // check printf pattern: printf( <var> )..
-        if(strstr(line, "printf(")){
-            char *q = strstr(line, "printf(");
-            q += strlen("printf(");
-            // find next ')'
-            char *r = strchr(q, ')');
-            if(!r){ printf("Line %d: printf missing closing parenthesis\n", lineno); return 0; }
-            // extract inside
-            char inside[256]; int len = (int)(r - q);
-            if (len >= (int)sizeof(inside)) len = (int)sizeof(inside)-1;
-            strncpy(inside, q, len); inside[len]=0;
-            // trim
-            char *s = inside; while(*s && isspace((unsigned char)*s)) s++;
-            char *t = inside + strlen(inside) - 1; while(t>=inside && isspace((unsigned char)*t)) *t--=0;
-            // If printf has comma-separated args (C-style), take the last argument as variable
-            if (strchr(s, ',')) {
-                char *last = s + strlen(s) - 1;
-                while(last > s && isspace((unsigned char)*last)) last--;
-                /* move back to char after previous comma */
-                while(last > s && *last != ',') last--;
-                if (*last == ',') last++; /* move to char after comma */
-                while(*last && isspace((unsigned char)*last)) last++;
-                s = last;
-            }
-            /* Accept either a variable or a string literal as printf argument (single-arg printf) */
-            if(!(s[0] == '"' || is_variable(s))){ printf("Line %d: printf argument not valid variable '%s'\n", lineno, s); return 0; }
-            // check terminator ".." or C-style ";" somewhere after r
-            if(strstr(r, "..")==NULL && strstr(r, ";")==NULL){ printf("Line %d: statement missing '..' or ';' terminator\n", lineno); return 0; }
-            continue;
-        }
-        // check variable declarations like: dec _input3k = 10..
-        if(strstr(line, "dec ") || strstr(line, "int ")){
-            // ensure variable name matches and terminator exists
-            /* if this is the function header for main, skip it */
-            if (strstr(line, "main(") || strstr(line, "main (")) continue;
-
-            char *typ = strstr(line, "dec ") ? strstr(line, "dec ") : strstr(line, "int ");
-            if(typ){
-                char buf[256];
-                strncpy(buf, typ, sizeof(buf)-1); buf[sizeof(buf)-1]=0;
-                // tokenise: type var = value..
-                char type[16], varname[128];
-                if(sscanf(buf, "%15s %127s", type, varname) >= 2){
-                    /* varname may contain trailing chars like "= 10.." so extract upto non-var chars (space or '=' or ';' or '.') */
-                    char vn[128]; int i=0;
-                    while (i < (int)strlen(varname) && varname[i] != '=' && varname[i] != ';' && varname[i] != '.' && !isspace((unsigned char)varname[i])) {
-                        vn[i] = varname[i];
-                        i++;
-                    }
-                    vn[i] = 0;
-                    if(!is_variable(vn) && !is_c_identifier(vn)){ printf("Line %d: invalid variable name '%s'\n", lineno, vn); return 0; }
-                    if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ printf("Line %d: missing '..' or ';' terminator\n", lineno); return 0; }
-                }
-            }
-            continue;
-        }
-        // check while loop pattern: while (dec _loopin0x < 3..) { 
-        if(strstr(line, "while")){
-            // must contain '(' and ')' and comparator <
-            if(strstr(line, "(") == NULL || strstr(line, ")") == NULL){ printf("Line %d: while parenthesis missing\n", lineno); return 0; }
-            if(strstr(line, "<") == NULL){ printf("Line %d: while comparator expected '<'\n", lineno); return 0; }
-            /* Allow C-style while with opening brace after the condition: "while (cond) {"
-               In that case don't require DSL terminator '..' or ';' in the same line. */
-            {
-                char *rp = strchr(line, ')');
-                if (rp) {
-                    char *brace_after = strchr(rp, '{');
-                    if (brace_after == NULL && strstr(line, "..") == NULL && strstr(line, ";") == NULL) {
-                        printf("Line %d: while condition missing '..' or ';'\n", lineno); return 0;
-                    }
-                }
-            }
-            /* Scan the original line for a variable token that matches is_variable pattern */
-            {
-                int found = 0;
-                int llen = (int)strlen(line);
-                int si;
-                for(si = 0; si < llen; si++){
-                    if(line[si] == '_'){
-                        /* extract token of alnum/_ chars starting at si */
-                        int sj = si;
-                        char cand[128]; int ck = 0;
-                        while(sj < llen && (isalnum((unsigned char)line[sj]) || line[sj] == '_')){
-                            if(ck < (int)sizeof(cand)-1) cand[ck++] = line[sj];
-                            sj++;
-                        }
-                        cand[ck] = 0;
-                        if(ck > 0 && (is_variable(cand) || is_c_identifier(cand))){
-                            found = 1;
-                            break;
-                        }
-                    }
-                }
-                if(!found){ printf("Line %d: while variable not found\n", lineno); return 0; }
-            }
-            continue;
-        }
-
-        // check return statement like return 0..
-        if(strstr(line, "return")){
-            if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ printf("Line %d: return missing '..' or ';'\n", lineno); return 0; }
-            continue;
-        }
+    pipe_result_init(&r);
+    if(!ti_open_mem(&tr, data, len)){ printf("PARSE ERROR: out of memory\n"); return 1; }
+    lex_init(&ls, pipe_count_token, &r);
+    ls.tok = tok;
+    sem_init(&s);
+    while((line = ti_getline(&tr, MAXLINE)) != NULL){
+        sm_pos pos = (sm_pos)ti_offset(&tr, line);
+        pipe_lex(&ls, &r, line, ++lineno);
+        pipe_check(&r, &s, line, lineno, pos, tok, ls.ntok);
+    }
+    if(tr.err){ r.input_err = tr.err; r.input_line = lineno + 1; }
+    ti_close(&tr);
+    return report_result(&r, &s, NULL, data, len);
+}
 
-        // if open brace or close brace or break with terminator
-        if(strstr(line, "break")){
-            if(strstr(line, "..") == NULL && strstr(line, ";") == NULL){ printf("Line %d: break missing '..' or ';'\n", lineno); return 0; }
-            continue;
+// batch mode: every file gets a "==> path <==" header and its verdict
+int run_batch(char **paths, int n, long *input_bytes){
+    bio_loader ld;
+    bio_file *bf;
+    int failed = 0;
+    bio_open(&ld, (const char *const *)paths, n, BIO_AUTO);
+    while((bf = bio_next(&ld)) != NULL){
+        printf("==> %s <==\n", bf->path);
+        if(bf->err){
+            printf("PARSE ERROR: cannot read file: %s\n", strerror(bf->err));
+            failed++;
+        } else {
+            *input_bytes += (long)bf->len;
+            if(run_memory(bf->data, bf->len) != 0) failed++;
         }
-
-        // for other lines, ensure if they contain '.' token then it's OK else assume it's code block or braces
-        continue;
+        bio_release(&ld, bf);
     }
-    return ok;
+    bio_close(&ld);
+    printf("\n==== %d files, %d accepted, %d rejected ====\n", n, n - failed, failed);
+    return failed ? 1 : 0;
 }
 
 int main(int argc, char **argv){
-    if(argc < 2){ printf("Usage: %s <source-file>\n", argv[0]); return 1; }
-    FILE *f = fopen(argv[1], "r");
-    if(!f){ perror("fopen"); return 1; }
-
-    if(!check_include_first(f)){
-        printf("PARSE ERROR: first line must be #include<stdio.h>\n");
-        fclose(f);
-        return 1;
+    int pipeline = 0, profile = 0, limit = 0, argi;
+    mp_stack_begin();
+    for(argi = 1; argi < argc; argi++){
+        if(strcmp(argv[argi], "--pipeline") == 0) pipeline = 1;
+        else if(strcmp(argv[argi], "--mem-profile") == 0) profile = 1;
+        else if(strcmp(argv[argi], "--mem-limit") == 0 && argi + 1 < argc){ profile = 1; limit = atoi(argv[++argi]); }
+        else break;
     }
-    if(!has_main_function(f)){
-        printf("PARSE ERROR: main function not found\n");
+    if(argi >= argc){ printf("Usage: %s [--pipeline] [--mem-profile] [--mem-limit KB-per-MB] <source-file>...\n", argv[0]); return 1; }
+    mp_on = profile;
+    MP_FRAME(MP_F_PARSER_MAIN);
+    long input_bytes = 0;
+    int rc;
+    if(argc - argi > 1){
+        // batch mode already overlaps reading with checking
+        if(pipeline){ printf("Usage: %s --pipeline [--mem-profile] [--mem-limit KB-per-MB] <source-file> (one file only)\n", argv[0]); return 1; }
+        rc = run_batch(argv + argi, argc - argi, &input_bytes);
+    } else {
+        FILE *f = fopen(argv[argi], "rb");
+        if(!f){ perror("fopen"); return 1; }
+        fseek(f, 0, SEEK_END);
+        input_bytes = ftell(f);
+        rewind(f);
+        rc = pipeline ? run_pipeline(f) : run_sequential(f);
         fclose(f);
-        return 1;
     }
-    if(!validate_structure(f)){
-        printf("PARSE ERROR: structure validation failed\n");
-        fclose(f);
-        return 1;
+
+    if(profile){
+        fflush(stdout);
+        mp_report(stderr, input_bytes);
+        if(limit > 0 && mp_kb_per_mb(input_bytes) > limit){
+            fprintf(stderr, "MEMORY LIMIT EXCEEDED: %.1f KB per MB of input (limit %d)\n", mp_kb_per_mb(input_bytes), limit);
+            rc = 3;
+        }
     }
-    printf("PARSE SUCCESS: Program ACCEPTED\n");
-    fclose(f);
-    return 0;
+    return rc;
 }
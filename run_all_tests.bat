@@ -30,6 +30,52 @@ for %%f in (test_input.txt test1.c test2.c test3.c test4.c test5.c test6.c nfa.d
     )
 )
 
+echo.
+echo ============================================
+echo PIPELINE CHECK
+echo ============================================
+echo --pipeline must print the same verdict as the default mode for every input.
+set PIPEFAIL=0
+for %%f in (*.c *.txt) do (
+    call .\project_parser.exe %%f > pipe_check_seq.out
+    call .\project_parser.exe --pipeline %%f > pipe_check_pipe.out
+    fc /b pipe_check_seq.out pipe_check_pipe.out > nul
+    if !errorlevel! neq 0 (
+        echo [FAIL] %%f: --pipeline and the default mode differ
+        set PIPEFAIL=1
+    )
+)
+del pipe_check_seq.out pipe_check_pipe.out
+if !PIPEFAIL! equ 0 echo [PASS] pipeline check
+
+echo.
+echo ============================================
+echo MEMORY REGRESSION CHECK
+echo ============================================
+echo Peak heap per MB of input must stay under the limits below.
+echo One long program, and one function of 16000 variables for the flow checks:
+echo Its names are _v, letters, then 1a, as the VAR rule wants.
+powershell -NoProfile -Command "[IO.File]::WriteAllText('mem_check_input.txt', \"#include<stdio.h>`nint main() {`n    int _v1a = 0..`n\" + ('    _v1a = _v1a + 1..' + \"`n\") * 200000 + \"    return 0..`n}`n\")"
+set MEMFAIL=0
+call .\project_lexer.exe --mem-limit 768 mem_check_input.txt > nul
+if !errorlevel! neq 0 set MEMFAIL=1
+call .\project_parser.exe --mem-limit 256 mem_check_input.txt > nul
+if !errorlevel! neq 0 set MEMFAIL=1
+call .\project_parser.exe --pipeline --mem-limit 256 mem_check_input.txt > nul
+if !errorlevel! neq 0 set MEMFAIL=1
+del mem_check_input.txt
+powershell -NoProfile -Command "$n = [char]10; $abc = 'abcdefghijklmnopqrstuvwxyz'; $body = -join (0..15999 | ForEach-Object { $i = $_; $s = ''; do { $s += $abc[$i %% 26]; $i = [math]::Floor($i / 26) } while ($i -gt 0); $v = '_v' + $s + '1a'; '    int ' + $v + ' = ' + $_ + '..' + $n + '    if (' + $v + ' > 3) {' + $n + '        _acc0a = _acc0a + ' + $v + '..' + $n + '    }' + $n }); [IO.File]::WriteAllText('mem_check_func.txt', '#include<stdio.h>' + $n + 'int main() {' + $n + '    int _acc0a = 0..' + $n + $body + '    return _acc0a..' + $n + '}' + $n)"
+call .\project_parser.exe --mem-limit 5120 mem_check_func.txt > nul
+if !errorlevel! neq 0 set MEMFAIL=1
+call .\project_parser.exe --pipeline --mem-limit 5120 mem_check_func.txt > nul
+if !errorlevel! neq 0 set MEMFAIL=1
+del mem_check_func.txt
+if !MEMFAIL! neq 0 (
+    echo [FAIL] memory regression check: lexer limit 768 KB/MB, parser limit 256 KB/MB, 5120 KB/MB for the one large function
+) else (
+    echo [PASS] memory regression check
+)
+
 echo.
 echo ============================================
 echo All tests complete.
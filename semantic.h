@@ -0,0 +1,717 @@
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+/* semantic.h
+   Declaration checks run by project_parser.c after the line checks
+   (in both the plain and the --pipeline mode).
+
+   Every identifier is interned once into a hashed string pool and is an
+   integer id from then on; its lexer class (VAR, FUNC_NAME, TYPE, ...)
+   is worked out on interning, not on every use.  Scopes are opened by
+   function bodies (*Fn and main), loop bodies (while, for) and plain
+   { } blocks.  Each id points at its innermost live binding and every
+   binding remembers the one it shadows, so a lookup is one array read
+   and closing a scope unwinds just the bindings it made: the pass is
+   linear in the size of the input.
+
+   Positions are 32-bit byte offsets into the source (source_map.h):
+   tokens, declarations and pending calls carry one, and a message keeps
+   its offset until sem_print_diag turns it into "Line N, column C".
+   Messages are kept in source order, the first SEM_MAX_DIAG of them.
+
+   Reported:
+   - use of an undeclared variable
+   - a variable declared twice in one scope, a function defined twice
+   - a call to a function that is never declared
+   - a dec value (dec variable or dec function result) stored into or
+     returned as an int; decimal literals are checked too, but the
+     lexer rejects "2.5" before the parser sees it
+   - from the control-flow checks (flow.h), run on each function body:
+     break or continue outside a loop, break to a label that is not an
+     enclosing loop, a variable read where it may not be assigned yet;
+     and as warnings, which do not reject: unreachable code, labels no
+     break targets, assigned values that are never read
+   Only names that match the VAR and FUNC_NAME rules (and main) are
+   checked, so the plain C identifiers in the test programs pass through.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "flow.h"
+#include "lexer_core.h"
+#include "lexer_tables.h"
+#include "memprof.h"
+#include "source_map.h"
+
+#define SEM_MAX_DIAG 20             // messages kept; the rest are only counted
+
+enum { SEM_NOTYPE, SEM_INT, SEM_DEC, SEM_CTYPE };  // SEM_CTYPE: char, float, ... (unchecked)
+
+// classes beyond the LEX_TOK_* ones, for words the lexer tables leave as IDENT
+#define SEM_KIND_FOR 100
+#define SEM_KIND_CTYPE 101
+#define SEM_KIND_IF 102             // C control words, SEM_KIND_IF + index in sem_cwords
+
+static const char *const sem_ctypes[] = {"char", "float", "double", "long", "short", "unsigned", "signed", "void"};
+static const char *const sem_cwords[] = {"if", "else", "do", "switch", "case", "default", "continue"};
+enum { SEM_SCOPE_GLOBAL, SEM_SCOPE_FUNC, SEM_SCOPE_LOOP, SEM_SCOPE_BLOCK };
+enum { SEM_T_IDENT, SEM_T_INT, SEM_T_DEC, SEM_T_STR, SEM_T_TERM, SEM_T_PUNCT };
+
+typedef struct {
+    int off, len;                   // name in the pool arena
+    unsigned hash;
+    int kind;                       // LEX_TOK_* class of the whole name
+    int type;                       // SEM_INT / SEM_DEC for int and dec
+    int binding;                    // innermost live symbol, -1 if none
+} sem_name;
+
+typedef struct {
+    sem_name *name;
+    int count, cap;
+    int *slot;                      // id + 1, 0 marks a free slot
+    int nslots;                     // power of two
+    char *arena;
+    int arena_used, arena_cap;
+} sem_pool;
+
+typedef struct {
+    int id;
+    int type;
+    int scope;                      // index in the scope stack
+    sm_pos pos;                     // declaration, or the body of a function
+    int prev;                       // binding shadowed by this one
+    int is_func, defined;
+    int var;                        // flow.h variable, -1 if its writes are not tracked
+} sem_symbol;
+
+typedef struct {
+    int kind;
+    int mark;                       // symbol count when the scope opened
+    int ret;                        // return type of a function scope
+} sem_scope;
+
+typedef struct {
+    int id, want;
+    sm_pos pos;
+} sem_call;
+
+typedef struct {
+    int kind, id, len;
+    const char *p;
+    sm_pos pos;
+} sem_tok;
+
+typedef struct {
+    sm_pos pos;
+    sm_pos ref;                     // earlier declaration it clashes with, or SM_NONE
+    char text[144];
+} sem_diag;
+
+typedef struct {
+    sem_pool pool;
+    sem_symbol *sym;
+    int nsym, sym_cap;
+    sem_scope *scope;
+    int nscope, scope_cap;
+    sem_call *call;                 // calls to functions not declared yet
+    int ncall, call_cap;
+    sem_tok *tok;
+    int tok_cap;
+
+    int in_comment;                 // inside /* */
+    int paren;
+    int pending;                    // header scope waiting for its '{', or -1
+    int pending_paren, pending_closed, pending_func;
+    int decl_type;                  // type word seen, next VAR is declared
+    int stmt_decl, stmt_paren;      // declaration statement, for "int _a1b, _b2c"
+    int lhs;                        // type the current expression is stored into
+
+    fl_state flow;
+
+    int errors, warnings;
+    int ndiag;
+    sem_diag diag[SEM_MAX_DIAG];
+} sem_state;
+
+static inline void *sem_grow(void *p, int *cap, int need, size_t size){
+    if(need <= *cap) return p;
+    int ncap = *cap ? *cap : 64;
+    while(ncap < need) ncap *= 2;
+    p = mp_realloc(MP_PARSER, p, (size_t)ncap * size);
+    if(!p){ fprintf(stderr, "semantic: out of memory\n"); exit(1); }
+    *cap = ncap;
+    return p;
+}
+
+// diag[] is kept in source order (the calls sem_finish settles, and the
+// flow findings of a function, are reported after the lines they are
+// on); when it is full the message furthest into the source makes room
+static inline void sem_add_diag(sem_state *s, sm_pos pos, sm_pos ref, const char *prefix, const char *fmt, va_list ap){
+    int i = s->ndiag;
+    if(i == SEM_MAX_DIAG){
+        if(pos >= s->diag[i - 1].pos) return;
+        i--;
+    } else s->ndiag++;
+    for(; i > 0 && s->diag[i - 1].pos > pos; i--) s->diag[i] = s->diag[i - 1];
+    sem_diag *d = &s->diag[i];
+    d->pos = pos;
+    d->ref = ref;
+    int n = snprintf(d->text, sizeof(d->text), "%s", prefix);
+    vsnprintf(d->text + n, sizeof(d->text) - n, fmt, ap);
+}
+
+static inline void sem_report(sem_state *s, sm_pos pos, sm_pos ref, const char *fmt, ...){
+    s->errors++;
+    va_list ap;
+    va_start(ap, fmt);
+    sem_add_diag(s, pos, ref, "", fmt, ap);
+    va_end(ap);
+}
+
+// a message that does not reject the program
+static inline void sem_warn(sem_state *s, sm_pos pos, const char *fmt, ...){
+    s->warnings++;
+    va_list ap;
+    va_start(ap, fmt);
+    sem_add_diag(s, pos, SM_NONE, "warning: ", fmt, ap);
+    va_end(ap);
+}
+
+static inline const char *sem_str(const sem_state *s, int id){
+    return s->pool.arena + s->pool.name[id].off;
+}
+
+static inline unsigned sem_hash(const char *p, int n){
+    unsigned h = 2166136261u;
+    for(int i = 0; i < n; i++){ h ^= (unsigned char)p[i]; h *= 16777619u; }
+    return h;
+}
+
+static inline void sem_rehash(sem_pool *pl){
+    int n = pl->nslots ? pl->nslots * 2 : 1024;
+    int *slot = (int *)mp_malloc(MP_PARSER, n * sizeof(int));
+    if(!slot){ fprintf(stderr, "semantic: out of memory\n"); exit(1); }
+    memset(slot, 0, n * sizeof(int));
+    for(int id = 0; id < pl->count; id++){
+        int i = pl->name[id].hash & (n - 1);
+        while(slot[i]) i = (i + 1) & (n - 1);
+        slot[i] = id + 1;
+    }
+    mp_free(pl->slot);
+    pl->slot = slot;
+    pl->nslots = n;
+}
+
+// returns the id of p[0..n), adding it on first sight
+static inline int sem_intern(sem_pool *pl, const char *p, int n){
+    unsigned h = sem_hash(p, n);
+    int i = h & (pl->nslots - 1);
+    while(pl->slot[i]){
+        sem_name *e = &pl->name[pl->slot[i] - 1];
+        if(e->hash == h && e->len == n && memcmp(pl->arena + e->off, p, n) == 0) return pl->slot[i] - 1;
+        i = (i + 1) & (pl->nslots - 1);
+    }
+    int id = pl->count++;
+    pl->name = (sem_name *)sem_grow(pl->name, &pl->cap, pl->count, sizeof(sem_name));
+    pl->arena = (char *)sem_grow(pl->arena, &pl->arena_cap, pl->arena_used + n + 1, 1);
+    sem_name *e = &pl->name[id];
+    e->off = pl->arena_used;
+    e->len = n;
+    e->hash = h;
+    memcpy(pl->arena + e->off, p, n);
+    pl->arena[e->off + n] = 0;
+    pl->arena_used += n + 1;
+    e->kind = dfa_classify(&lex_ident_dfa, p, n);
+    e->type = e->kind != LEX_TOK_TYPE ? SEM_NOTYPE : p[0] == 'd' ? SEM_DEC : SEM_INT;
+    if(e->kind == LEX_TOK_NONE){
+        if(n == 3 && memcmp(p, "for", 3) == 0) e->kind = SEM_KIND_FOR;
+        for(int k = 0; k < (int)(sizeof(sem_cwords) / sizeof(sem_cwords[0])); k++)
+            if((int)strlen(sem_cwords[k]) == n && memcmp(sem_cwords[k], p, n) == 0) e->kind = SEM_KIND_IF + k;
+        for(int k = 0; k < (int)(sizeof(sem_ctypes) / sizeof(sem_ctypes[0])); k++)
+            if((int)strlen(sem_ctypes[k]) == n && memcmp(sem_ctypes[k], p, n) == 0){ e->kind = SEM_KIND_CTYPE; e->type = SEM_CTYPE; }
+    }
+    e->binding = -1;
+    pl->slot[i] = id + 1;
+    if(pl->count * 2 > pl->nslots) sem_rehash(pl);
+    return id;
+}
+
+static inline void sem_push_scope(sem_state *s, int kind, int ret){
+    s->scope = (sem_scope *)sem_grow(s->scope, &s->scope_cap, s->nscope + 1, sizeof(sem_scope));
+    s->scope[s->nscope].kind = kind;
+    s->scope[s->nscope].mark = s->nsym;
+    s->scope[s->nscope].ret = ret;
+    s->nscope++;
+}
+
+static inline void sem_pop_scope(sem_state *s){
+    if(s->nscope <= 1) return;      // a stray '}' never closes the global scope
+    s->nscope--;
+    while(s->nsym > s->scope[s->nscope].mark){
+        sem_symbol *y = &s->sym[--s->nsym];
+        s->pool.name[y->id].binding = y->prev;
+    }
+}
+
+static inline sem_symbol *sem_declare(sem_state *s, int id, int type, int scope, sm_pos pos){
+    s->sym = (sem_symbol *)sem_grow(s->sym, &s->sym_cap, s->nsym + 1, sizeof(sem_symbol));
+    sem_symbol *y = &s->sym[s->nsym];
+    y->id = id;
+    y->type = type;
+    y->scope = scope;
+    y->pos = pos;
+    y->prev = s->pool.name[id].binding;
+    y->is_func = y->defined = 0;
+    y->var = -1;
+    s->pool.name[id].binding = s->nsym++;
+    return y;
+}
+
+static inline void sem_init(sem_state *s){
+    memset(s, 0, sizeof(*s));
+    sem_rehash(&s->pool);
+    s->pending = -1;
+    sem_push_scope(s, SEM_SCOPE_GLOBAL, SEM_NOTYPE);
+    fl_init(&s->flow);
+}
+
+static inline void sem_free(sem_state *s){
+    mp_free(s->pool.name);
+    mp_free(s->pool.slot);
+    mp_free(s->pool.arena);
+    mp_free(s->sym);
+    mp_free(s->scope);
+    mp_free(s->call);
+    mp_free(s->tok);
+    fl_free(&s->flow);
+    memset(s, 0, sizeof(*s));
+}
+
+// splits one line (starting at offset base) into tokens; comments and
+// preprocessor lines are dropped
+static inline int sem_tokenize(sem_state *s, const char *p, sm_pos base){
+    const char *line = p;
+    int n = 0;
+    s->tok = (sem_tok *)sem_grow(s->tok, &s->tok_cap, (int)strlen(p) + 1, sizeof(sem_tok));
+    while(*p){
+        if(s->in_comment){
+            if(p[0] == '*' && p[1] == '/'){ s->in_comment = 0; p += 2; }
+            else p++;
+            continue;
+        }
+        unsigned char c = (unsigned char)*p;
+        if(lex_cclass[c] & LEX_C_SPACE){ p++; continue; }
+        if(c == '/' && p[1] == '/') break;
+        if(c == '/' && p[1] == '*'){ s->in_comment = 1; p += 2; continue; }
+        if(c == '#' && n == 0) break;          // preprocessor line
+        sem_tok *t = &s->tok[n++];
+        t->p = p;
+        t->pos = base + (sm_pos)(p - line);
+        if(lex_cclass[c] & LEX_C_IDENT_START){
+            while(lex_cclass[(unsigned char)*p] & LEX_C_IDENT_CHAR) p++;
+            t->kind = SEM_T_IDENT;
+            t->id = sem_intern(&s->pool, t->p, (int)(p - t->p));
+        } else if(lex_cclass[c] & LEX_C_DIGIT){
+            while(lex_cclass[(unsigned char)*p] & LEX_C_DIGIT) p++;
+            t->kind = SEM_T_INT;
+            // "3.5" is a dec literal, "3.." is 3 followed by the terminator
+            if(p[0] == '.' && (lex_cclass[(unsigned char)p[1]] & LEX_C_DIGIT)){
+                p++;
+                while(lex_cclass[(unsigned char)*p] & LEX_C_DIGIT) p++;
+                t->kind = SEM_T_DEC;
+            }
+        } else if(c == '"' || c == '\''){
+            p++;
+            while(*p && *p != (char)c){ if(*p == '\\' && p[1]) p++; p++; }
+            if(*p) p++;
+            t->kind = SEM_T_STR;
+        } else if(c == ';' || (c == '.' && p[1] == '.')){
+            p += c == ';' ? 1 : 2;
+            t->kind = SEM_T_TERM;
+        } else {
+            p++;
+            t->kind = SEM_T_PUNCT;
+        }
+        t->len = (int)(p - t->p);
+    }
+    return n;
+}
+
+// the same from the tokens lex_line stored for the line (ls->tok), so
+// the boundaries are the lexer's: a NUM is always an int, a label is its
+// name and a ':', and "//" or "/*" are two adjacent '/' '*' symbols
+static inline int sem_from_lexer(sem_state *s, const char *line, sm_pos base, const lex_tok *lt, int nt){
+    int n = 0;
+    s->tok = (sem_tok *)sem_grow(s->tok, &s->tok_cap, (int)strlen(line) + 1, sizeof(sem_tok));
+    for(int i = 0; i < nt; i++){
+        const char *p = line + lt[i].at;
+        char c = lt[i].kind == LEX_K_SYM ? p[0] : 0;
+        char c2 = i + 1 < nt && lt[i + 1].kind == LEX_K_SYM && lt[i + 1].at == lt[i].at + 1 ? p[1] : 0;
+        int len = lt[i].len, kind;
+        if(s->in_comment){
+            if(c == '*' && c2 == '/'){ s->in_comment = 0; i++; }
+            continue;
+        }
+        if(c == '/' && c2 == '/') break;
+        if(c == '/' && c2 == '*'){ s->in_comment = 1; i++; continue; }
+        switch(lt[i].kind){
+        case LEX_K_INCLUDE: case LEX_K_COMMENT: continue;
+        case LEX_K_WORD: kind = SEM_T_IDENT; break;
+        case LEX_K_LABEL:
+            kind = SEM_T_IDENT;
+            len = 0;
+            while(lex_cclass[(unsigned char)p[len]] & LEX_C_IDENT_CHAR) len++;
+            break;
+        case LEX_K_NUM: kind = SEM_T_INT; break;
+        case LEX_K_STRING: case LEX_K_CHAR: kind = SEM_T_STR; break;
+        case LEX_K_STMT_END: kind = SEM_T_TERM; break;
+        default: kind = c == ';' ? SEM_T_TERM : SEM_T_PUNCT; break;
+        }
+        sem_tok *t = &s->tok[n++];
+        t->kind = kind;
+        t->p = p;
+        t->len = len;
+        t->pos = base + lt[i].at;
+        if(kind == SEM_T_IDENT) t->id = sem_intern(&s->pool, p, len);
+        // the rest of a label ("loop_a01:" leaves the ':')
+        for(p += len; p < line + lt[i].at + lt[i].len; p++){
+            t = &s->tok[n++];
+            t->kind = SEM_T_PUNCT;
+            t->p = p;
+            t->len = 1;
+            t->pos = base + (sm_pos)(p - line);
+        }
+    }
+    return n;
+}
+
+static inline int sem_is_punct(const sem_tok *t, char c){
+    return t && t->kind == SEM_T_PUNCT && t->p[0] == c;
+}
+
+static inline void sem_end_stmt(sem_state *s){
+    s->decl_type = SEM_NOTYPE;
+    s->stmt_decl = SEM_NOTYPE;
+    s->lhs = SEM_NOTYPE;
+}
+
+static inline int sem_func_ret(const sem_state *s){
+    for(int i = s->nscope - 1; i > 0; i--)
+        if(s->scope[i].kind == SEM_SCOPE_FUNC) return s->scope[i].ret;
+    return SEM_NOTYPE;
+}
+
+// a value of type got used where lhs is expected
+static inline void sem_check_value(sem_state *s, int got, const sem_tok *t){
+    if(s->lhs == SEM_INT && got == SEM_DEC){
+        sem_report(s, t->pos, SM_NONE, "type mismatch, dec value '%.*s' used as int", t->len, t->p);
+        s->lhs = SEM_NOTYPE;        // one report per statement
+    }
+}
+
+static inline void sem_open_header(sem_state *s, int kind, int ret, int func){
+    sem_push_scope(s, kind, ret);
+    s->pending = s->nscope - 1;
+    s->pending_paren = s->paren;
+    s->pending_closed = 0;
+    s->pending_func = func;
+}
+
+// no operand before it: prev makes the next operator unary
+static inline int sem_is_unary(const sem_tok *prev){
+    return !prev || prev->kind == SEM_T_TERM || (prev->kind == SEM_T_PUNCT && prev->p[0] != ')' && prev->p[0] != ']');
+}
+
+// "++", "+=": two operator characters with nothing between them
+static inline int sem_is_pair(const sem_tok *a, const sem_tok *b, char second){
+    return a && b && a->kind == SEM_T_PUNCT && sem_is_punct(b, second ? second : a->p[0]) && b->p == a->p + 1 &&
+           (second || a->p[0] == '+' || a->p[0] == '-');
+}
+
+// tells flow.h how this use of a tracked variable reads or writes it
+static inline void sem_flow_var(sem_state *s, int var, const sem_tok *t, const sem_tok *prev, const sem_tok *prev2,
+                                const sem_tok *next, const sem_tok *next2, int assign){
+    if(var < 0) return;
+    if(sem_is_punct(prev, '&') && sem_is_unary(prev2)) fl_escape(&s->flow, var);
+    else if((sem_is_punct(prev, '*') && sem_is_unary(prev2)) || sem_is_punct(next, '[')) fl_read(&s->flow, var, t->pos);
+    else if(assign) fl_assign(&s->flow, var, t->pos);
+    else if(sem_is_pair(next, next2, 0) || sem_is_pair(prev2, prev, 0) ||
+            (next && strchr("+-*/%", next->p[0]) && sem_is_pair(next, next2, '='))) fl_update(&s->flow, var, t->pos);
+    else fl_read(&s->flow, var, t->pos);
+}
+
+static inline void sem_ident(sem_state *s, const sem_tok *t, const sem_tok *next, const sem_tok *next2,
+                             const sem_tok *prev, const sem_tok *prev2){
+    sem_name *nm = &s->pool.name[t->id];
+    int decl = s->decl_type;
+    s->decl_type = SEM_NOTYPE;
+
+    if(sem_is_punct(next, '(') && s->nscope == 1 && s->pending < 0 && nm->kind != LEX_TOK_VAR &&
+       (decl || nm->kind == LEX_TOK_FUNC_NAME || nm->kind == LEX_TOK_MAIN)){
+        // header at file level: "int addFn(int _x1a) {", "main() {", "int transition(...)"
+        int ret = decl ? decl : SEM_INT;
+        if(nm->binding < 0 || !s->sym[nm->binding].is_func){
+            sem_symbol *y = sem_declare(s, t->id, ret, 0, t->pos);
+            y->is_func = 1;
+        }
+        s->stmt_decl = SEM_NOTYPE;
+        sem_open_header(s, SEM_SCOPE_FUNC, ret, t->id);
+        return;
+    }
+
+    switch(nm->kind){
+    case LEX_TOK_TYPE:
+    case SEM_KIND_CTYPE:
+        s->decl_type = s->stmt_decl = nm->type;
+        s->stmt_paren = s->paren;
+        return;
+    case LEX_TOK_RETURN:
+        s->lhs = sem_func_ret(s);
+        return;
+    case LEX_TOK_WHILE:
+    case SEM_KIND_FOR:
+        if(s->pending < 0 && sem_is_punct(next, '(')) sem_open_header(s, SEM_SCOPE_LOOP, SEM_NOTYPE, -1);
+        return;
+    case LEX_TOK_FUNC_NAME:
+    case LEX_TOK_MAIN:
+        if(!sem_is_punct(next, '(')) return;
+        if(nm->binding >= 0 && s->sym[nm->binding].is_func){
+            sem_check_value(s, s->sym[nm->binding].type, t);
+        } else {
+            // may be defined further down; settled in sem_finish
+            s->call = (sem_call *)sem_grow(s->call, &s->call_cap, s->ncall + 1, sizeof(sem_call));
+            s->call[s->ncall].id = t->id;
+            s->call[s->ncall].pos = t->pos;
+            s->call[s->ncall].want = s->lhs;
+            s->ncall++;
+        }
+        return;
+    case LEX_TOK_VAR:
+        break;
+    default:
+        return;
+    }
+
+    int assign = sem_is_punct(next, '=') && !sem_is_punct(next2, '=');
+    if(decl){
+        int b = nm->binding;
+        if(b >= 0 && s->sym[b].scope == s->nscope - 1)
+            sem_report(s, t->pos, s->sym[b].pos, "'%s' already declared in this scope", sem_str(s, t->id));
+        sem_symbol *y = sem_declare(s, t->id, decl, s->nscope - 1, t->pos);
+        // arrays are written element by element: not tracked
+        if(!sem_is_punct(next, '[')) y->var = fl_decl(&s->flow, t->id, t->pos, assign);
+        if(assign) s->lhs = decl;
+        return;
+    }
+    if(nm->binding < 0){
+        sem_report(s, t->pos, SM_NONE, "undeclared variable '%s'", sem_str(s, t->id));
+        return;
+    }
+    if(assign) s->lhs = s->sym[nm->binding].type;
+    else sem_check_value(s, s->sym[nm->binding].type, t);
+    sem_flow_var(s, s->sym[nm->binding].var, t, prev, prev2, next, next2, assign);
+}
+
+// how flow.h sees a token
+static inline int sem_flow_class(const sem_state *s, const sem_tok *t, const sem_tok *next){
+    if(t->kind == SEM_T_TERM) return FL_T_TERM;
+    if(t->kind == SEM_T_PUNCT){
+        switch(t->p[0]){
+        case '{': return FL_T_LBRACE;
+        case '}': return FL_T_RBRACE;
+        case '(': return FL_T_LPAREN;
+        case ')': return FL_T_RPAREN;
+        case ',': return FL_T_COMMA;
+        case ':': return FL_T_COLON;
+        }
+        return FL_T_OTHER;
+    }
+    if(t->kind != SEM_T_IDENT) return FL_T_OTHER;
+    switch(s->pool.name[t->id].kind){
+    case LEX_TOK_WHILE: return FL_T_WHILE;
+    case LEX_TOK_BREAK: return FL_T_BREAK;
+    case LEX_TOK_RETURN: return FL_T_RETURN;
+    case SEM_KIND_FOR: return FL_T_FOR;
+    case SEM_KIND_IF: return FL_T_IF;
+    case SEM_KIND_IF + 1: return FL_T_ELSE;
+    case SEM_KIND_IF + 2: return FL_T_DO;
+    case SEM_KIND_IF + 3: return FL_T_SWITCH;
+    case SEM_KIND_IF + 4: return FL_T_CASE;
+    case SEM_KIND_IF + 5: return FL_T_DEFAULT;
+    case SEM_KIND_IF + 6: return FL_T_CONTINUE;
+    }
+    if(t->len > 5 && memcmp(t->p, "loop_", 5) == 0 && sem_is_punct(next, ':')) return FL_T_LABEL;
+    return FL_T_IDENT;
+}
+
+// turns the findings of a finished function into messages, in source order
+static inline void sem_flow_report(sem_state *s){
+    fl_state *fl = &s->flow;
+    for(int i = 1; i < fl->nfind; i++){
+        fl_finding f = fl->find[i];
+        int j = i;
+        while(j > 0 && fl->find[j - 1].pos > f.pos){ fl->find[j] = fl->find[j - 1]; j--; }
+        fl->find[j] = f;
+    }
+    for(int i = 0; i < fl->nfind; i++){
+        const fl_finding *f = &fl->find[i];
+        const char *name = f->name >= 0 ? sem_str(s, f->name) : "";
+        switch(f->kind){
+        case FL_F_BREAK_OUTSIDE: sem_report(s, f->pos, SM_NONE, "break outside a loop or switch"); break;
+        case FL_F_CONTINUE_OUTSIDE: sem_report(s, f->pos, SM_NONE, "continue outside a loop"); break;
+        case FL_F_BREAK_NOT_ENCLOSING: sem_report(s, f->pos, SM_NONE, "break target '%s' is not an enclosing loop", name); break;
+        case FL_F_BREAK_NO_LABEL: sem_report(s, f->pos, SM_NONE, "break to undeclared label '%s'", name); break;
+        case FL_F_UNASSIGNED: sem_report(s, f->pos, SM_NONE, "'%s' may be used before it is assigned", name); break;
+        case FL_F_UNREACHABLE: sem_warn(s, f->pos, "unreachable code"); break;
+        case FL_F_LABEL_UNUSED: sem_warn(s, f->pos, "label '%s' is never the target of a break", name); break;
+        case FL_F_DEAD_STORE: sem_warn(s, f->pos, "value assigned to '%s' is never read", name); break;
+        }
+    }
+    fl->nfind = 0;
+}
+
+// checks the n tokens of one line in s->tok
+static inline void sem_run(sem_state *s, int n){
+    for(int i = 0; i < n; i++){
+        const sem_tok *t = &s->tok[i];
+        const sem_tok *next = i + 1 < n ? &s->tok[i + 1] : NULL;
+        const sem_tok *next2 = i + 2 < n ? &s->tok[i + 2] : NULL;
+        const sem_tok *prev = i > 0 ? &s->tok[i - 1] : NULL;
+        const sem_tok *prev2 = i > 1 ? &s->tok[i - 2] : NULL;
+
+        // the closing '}' of a function runs its flow checks
+        if(s->flow.active && fl_token(&s->flow, sem_flow_class(s, t, next), t->kind == SEM_T_IDENT ? t->id : -1, t->pos))
+            sem_flow_report(s);
+
+        if(s->pending >= 0 && s->pending_closed){
+            int func = s->pending_func;
+            s->pending = -1;
+            if(sem_is_punct(t, '{')){
+                // the header's scope becomes the body
+                sem_end_stmt(s);
+                if(func >= 0){
+                    sem_symbol *y = &s->sym[s->pool.name[func].binding];
+                    if(y->defined) sem_report(s, t->pos, y->pos, "function '%s' already defined", sem_str(s, func));
+                    else { y->defined = 1; y->pos = t->pos; }
+                    fl_begin_function(&s->flow);
+                }
+                continue;
+            }
+            // a prototype, a call or a loop without braces: no body scope
+            sem_pop_scope(s);
+        }
+
+        switch(t->kind){
+        case SEM_T_IDENT:
+            sem_ident(s, t, next, next2, prev, prev2);
+            break;
+        case SEM_T_DEC:
+            s->decl_type = SEM_NOTYPE;
+            sem_check_value(s, SEM_DEC, t);
+            break;
+        case SEM_T_TERM:
+            sem_end_stmt(s);
+            break;
+        case SEM_T_PUNCT:
+            // "char * _str1a" is still a declaration
+            if(t->p[0] != '*') s->decl_type = SEM_NOTYPE;
+            switch(t->p[0]){
+            case '(':
+                s->paren++;
+                break;
+            case ')':
+                if(s->paren > 0) s->paren--;
+                if(s->pending >= 0 && s->paren == s->pending_paren) s->pending_closed = 1;
+                break;
+            case '{':
+                sem_end_stmt(s);
+                sem_push_scope(s, SEM_SCOPE_BLOCK, SEM_NOTYPE);
+                break;
+            case '}':
+                sem_end_stmt(s);
+                sem_pop_scope(s);
+                s->paren = 0;
+                break;
+            case ',':
+                if(s->stmt_decl && s->paren == s->stmt_paren){
+                    s->decl_type = s->stmt_decl;
+                    s->lhs = SEM_NOTYPE;
+                }
+                break;
+            }
+            break;
+        default:
+            s->decl_type = SEM_NOTYPE;
+            break;
+        }
+    }
+}
+
+// checks one line as read by fgets; pos is the offset of its first byte
+static inline void sem_line(sem_state *s, const char *line, sm_pos pos){
+    MP_FRAME(MP_F_SEM_LINE);
+    sem_run(s, sem_tokenize(s, line, pos));
+}
+
+// checks one line the lexer has split, its nt tokens in lt (lex_state.tok)
+static inline void sem_line_tokens(sem_state *s, const char *line, sm_pos pos, const lex_tok *lt, int nt){
+    MP_FRAME(MP_F_SEM_LINE);
+    sem_run(s, sem_from_lexer(s, line, pos, lt, nt));
+}
+
+// settles calls made before the callee was declared and the flow checks
+// of an unclosed function; returns the error count (warnings are apart)
+static inline int sem_finish(sem_state *s){
+    if(s->flow.active){             // the input ended inside a function
+        fl_end_function(&s->flow);
+        sem_flow_report(s);
+    }
+    for(int i = 0; i < s->ncall; i++){
+        sem_call *c = &s->call[i];
+        int b = s->pool.name[c->id].binding;
+        while(b >= 0 && !s->sym[b].is_func) b = s->sym[b].prev;
+        if(b < 0){
+            sem_report(s, c->pos, SM_NONE, "call to undeclared function '%s'", sem_str(s, c->id));
+        } else if(c->want == SEM_INT && s->sym[b].type == SEM_DEC){
+            sem_report(s, c->pos, SM_NONE, "type mismatch, dec value '%s' used as int", sem_str(s, c->id));
+        }
+    }
+    s->ncall = 0;
+    return s->errors;
+}
+
+// the offsets sem_print_diag will look up, ascending and without repeats,
+// into out (room for 2 * SEM_MAX_DIAG); for sm_init_sparse. Returns how many.
+static inline unsigned sem_diag_offsets(const sem_state *s, sm_pos *out){
+    unsigned n = 0, i, j;
+    for(int k = 0; k < s->ndiag; k++){
+        sm_pos p[2] = { s->diag[k].pos, s->diag[k].ref };
+        for(int e = 0; e < 2; e++){
+            if(p[e] == SM_NONE) continue;
+            i = 0;
+            while(i < n && out[i] < p[e]) i++;
+            if(i < n && out[i] == p[e]) continue;
+            for(j = n++; j > i; j--) out[j] = out[j - 1];
+            out[i] = p[e];
+        }
+    }
+    return n;
+}
+
+// prints the kept messages, placed with m (the map of the text sem_line saw)
+static inline void sem_print_diag(const sem_state *s, sm_map *m, FILE *out){
+    for(int i = 0; i < s->ndiag; i++){
+        const sem_diag *d = &s->diag[i];
+        sm_loc at = sm_lookup(m, d->pos);
+        if(at.line) fprintf(out, "Line %u, column %u: %s", at.line, at.col, d->text);
+        else fprintf(out, "%s", d->text);
+        if(d->ref != SM_NONE){
+            sm_loc ref = sm_lookup(m, d->ref);
+            if(ref.line) fprintf(out, " (line %u)", ref.line);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+#endif /* SEMANTIC_H */
@@ -0,0 +1,365 @@
+#ifndef SOURCE_MAP_H
+#define SOURCE_MAP_H
+/* source_map.h
+    Offset -> line/column table for diagnostics.  A position anywhere in
+    the parser is one 32-bit byte offset; the line and column are only
+    worked out when a message is printed.
+    sm_add_text() appends a file (a buffer, or a mapped file: it is only
+    read during the call) and sm_add_stream() one read from a FILE; each
+    file gets the next range of the offset space, so one map covers many
+    files.  sm_extend() adds more of the last file, for text that comes
+    a block at a time from somewhere other than a FILE.  One pass over
+    the text records where every line starts, with SSE2 finding the
+    newlines 16 bytes at a time.
+    A map set up with sm_init_sparse() is told up front which offsets
+    will be looked up (a handful of diagnostics) and keeps only the lines
+    holding them, with their numbers, so its size does not grow with the
+    text; it answers for those offsets only.
+    Lookups go through a bucket table built on first use: bucket b holds
+    the line that contains offset b << shift, with the shift picked so
+    there are about as many buckets as lines.  A lookup reads its bucket
+    and the next one and searches the few lines between them, so it
+    costs the same however many lines the map holds.
+    Columns count bytes of UTF-8, from 1.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memprof.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SM_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#define SM_NONE 0xFFFFFFFFu         /* no position */
+#define SM_BLOCK (64 * 1024)        /* sm_add_stream read size */
+
+typedef unsigned int sm_pos;
+
+typedef struct {
+    const char *name;
+    sm_pos base;                    /* offset of the first byte */
+    unsigned first;                 /* index of its first line in start[] */
+} sm_file;
+
+typedef struct {
+    sm_pos *start;                  /* offset where each line starts, ascending */
+    unsigned nlines, cap;
+    sm_file *file;
+    int nfiles, file_cap;
+    sm_pos end;                     /* offset just past the last file */
+    unsigned *bucket;               /* line holding offset b << shift */
+    unsigned nbuckets;
+    int shift;
+    int dirty;                      /* lines added since the buckets were built */
+    /* sparse map: start[] and lineno[] hold only the lines with a wanted offset */
+    int sparse;
+    unsigned *lineno;               /* number of each start[] line in its file */
+    const sm_pos *want;             /* offsets to be looked up, ascending */
+    unsigned nwant, next_want;      /* want[next_want] is not placed yet */
+    sm_pos line_start;              /* the line being scanned */
+    unsigned line_no;
+} sm_map;
+
+typedef struct {
+    const char *file;
+    unsigned line, col;             /* from 1; 0 when the offset is not in the map */
+} sm_loc;
+
+static inline void sm_init(sm_map *m)
+{
+    memset(m, 0, sizeof(*m));
+}
+
+/* A sparse map answering for want[0..n), which is ascending and must
+   outlive the map. */
+static inline void sm_init_sparse(sm_map *m, const sm_pos *want, unsigned n)
+{
+    sm_init(m);
+    m->sparse = 1;
+    m->want = want;
+    m->nwant = n;
+}
+
+static inline void sm_free(sm_map *m)
+{
+    mp_free(m->start);
+    mp_free(m->lineno);
+    mp_free(m->file);
+    mp_free(m->bucket);
+    memset(m, 0, sizeof(*m));
+}
+
+/* Empties the map but keeps its arrays for the next file. */
+static inline void sm_reset(sm_map *m)
+{
+    m->nlines = 0;
+    m->nfiles = 0;
+    m->end = 0;
+    m->dirty = 1;
+    m->next_want = 0;
+}
+
+static inline int sm_reserve(sm_map *m, unsigned more)
+{
+    unsigned ncap;
+    sm_pos *p;
+
+    if (m->nlines + more <= m->cap) return 1;
+    ncap = m->cap ? m->cap : 1024;
+    while (ncap < m->nlines + more) ncap *= 2;
+    p = (sm_pos *)mp_realloc(MP_PARSER, m->start, (size_t)ncap * sizeof(sm_pos));
+    if (!p) return 0;
+    m->start = p;
+    if (m->sparse) {
+        unsigned *q = (unsigned *)mp_realloc(MP_PARSER, m->lineno, (size_t)ncap * sizeof(unsigned));
+        if (!q) return 0;
+        m->lineno = q;
+    }
+    m->cap = ncap;
+    return 1;
+}
+
+/* Sparse map: keeps the line being scanned if a wanted offset below
+   next falls in it. */
+static inline int sm_sparse_keep(sm_map *m, sm_pos next)
+{
+    if (m->next_want == m->nwant || m->want[m->next_want] >= next) return 1;
+    while (m->next_want < m->nwant && m->want[m->next_want] < next) m->next_want++;
+    if (!sm_reserve(m, 1)) return 0;
+    m->start[m->nlines] = m->line_start;
+    m->lineno[m->nlines++] = m->line_no;
+    return 1;
+}
+
+/* sm_scan for a sparse map: only counts the lines between wanted offsets */
+static inline int sm_scan_sparse(sm_map *m, const char *s, size_t n, sm_pos at)
+{
+    size_t i = 0;
+    const char *nl;
+
+    while (i < n && (nl = (const char *)memchr(s + i, '\n', n - i)) != NULL) {
+        i = (size_t)(nl - s) + 1;
+        if (!sm_sparse_keep(m, at + (sm_pos)i)) return 0;
+        m->line_start = at + (sm_pos)i;
+        m->line_no++;
+    }
+    return 1;
+}
+
+#ifdef SM_SSE2
+static inline int sm_ctz(unsigned x)
+{
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+#else
+    return __builtin_ctz(x);
+#endif
+}
+#endif
+
+/* Records a line start after every '\n' in s[0..n), whose first byte is
+   at offset at.  After a final newline this is the offset where the next
+   file starts; lookups take the later of two equal starts, so that
+   offset belongs to the next file.  Returns 0 when out of memory. */
+static inline int sm_scan(sm_map *m, const char *s, size_t n, sm_pos at)
+{
+    size_t i = 0;
+    const char *nl;
+
+    if (m->sparse) return sm_scan_sparse(m, s, n, at);
+#ifdef SM_SSE2
+    {
+        const __m128i lf = _mm_set1_epi8('\n');
+        unsigned mask;
+        while (i + 16 <= n) {
+            mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(s + i)), lf));
+            while (mask) {
+                if (m->nlines == m->cap && !sm_reserve(m, 1024)) return 0;
+                m->start[m->nlines++] = at + (sm_pos)(i + sm_ctz(mask) + 1);
+                mask &= mask - 1;
+            }
+            i += 16;
+        }
+    }
+#endif
+    while (i < n && (nl = (const char *)memchr(s + i, '\n', n - i)) != NULL) {
+        i = (size_t)(nl - s) + 1;
+        if (m->nlines == m->cap && !sm_reserve(m, 1024)) return 0;
+        m->start[m->nlines++] = at + (sm_pos)i;
+    }
+    return 1;
+}
+
+static inline int sm_begin_file(sm_map *m, const char *name)
+{
+    sm_file *f;
+
+    if (m->nfiles == m->file_cap) {
+        int ncap = m->file_cap ? m->file_cap * 2 : 8;
+        f = (sm_file *)mp_realloc(MP_PARSER, m->file, ncap * sizeof(sm_file));
+        if (!f) return 0;
+        m->file = f;
+        m->file_cap = ncap;
+    }
+    if (m->sparse) {
+        /* the last line of the previous file */
+        if (m->nfiles && !sm_sparse_keep(m, m->end)) return 0;
+        m->line_start = m->end;
+        m->line_no = 1;
+    } else if (!sm_reserve(m, 1)) {
+        return 0;
+    }
+    f = &m->file[m->nfiles++];
+    f->name = name;
+    f->base = m->end;
+    f->first = m->nlines;
+    if (!m->sparse) m->start[m->nlines++] = m->end;
+    m->dirty = 1;
+    return 1;
+}
+
+/* Adds text[0..len) as the next file; name is kept as a pointer.
+   Returns the offset of its first byte, or SM_NONE when out of memory
+   or when the map would pass 4 GB. */
+static inline sm_pos sm_add_text(sm_map *m, const char *name, const char *text, size_t len)
+{
+    sm_pos base = m->end;
+
+    if (len >= (size_t)(SM_NONE - base)) return SM_NONE;
+    if (!sm_begin_file(m, name)) return SM_NONE;
+    if (!sm_scan(m, text, len, base)) return SM_NONE;
+    m->end = base + (sm_pos)len;
+    return base;
+}
+
+/* Same for a file read from f's current position to its end. */
+static inline sm_pos sm_add_stream(sm_map *m, const char *name, FILE *f)
+{
+    sm_pos base = m->end, at = base;
+    char *buf;
+    size_t n;
+    int ok = 1;
+
+    buf = (char *)mp_malloc(MP_PARSER, SM_BLOCK);
+    if (!buf || !sm_begin_file(m, name)) {
+        mp_free(buf);
+        return SM_NONE;
+    }
+    while (ok && (n = fread(buf, 1, SM_BLOCK, f)) > 0) {
+        if (n >= (size_t)(SM_NONE - at)) ok = 0;
+        else ok = sm_scan(m, buf, n, at);
+        at += (sm_pos)n;
+    }
+    mp_free(buf);
+    if (!ok) return SM_NONE;
+    m->end = at;
+    return base;
+}
+
+/* Adds text[0..len) to the last file, at offset at from its first byte;
+   at is not below the end of what the file holds so far.  Returns 0 when
+   out of memory or past 4 GB. */
+static inline int sm_extend(sm_map *m, const char *text, size_t len, sm_pos at)
+{
+    sm_pos base;
+
+    if (m->nfiles == 0) return 0;
+    base = m->file[m->nfiles - 1].base;
+    if (at >= SM_NONE - base || len >= (size_t)(SM_NONE - base - at)) return 0;
+    if (!sm_scan(m, text, len, base + at)) return 0;
+    m->end = base + at + (sm_pos)len;
+    m->dirty = 1;
+    return 1;
+}
+
+static inline int sm_build_buckets(sm_map *m)
+{
+    unsigned nb, b, line;
+    unsigned *p;
+    int shift = 0;
+
+    /* about one bucket per line */
+    while (shift < 31 && ((m->end >> shift) + 1) > m->nlines) shift++;
+    nb = (m->end >> shift) + 2;
+    if (nb > m->nbuckets) {
+        p = (unsigned *)mp_realloc(MP_PARSER, m->bucket, (size_t)nb * sizeof(unsigned));
+        if (!p) return 0;
+        m->bucket = p;
+    }
+    m->nbuckets = nb;
+    m->shift = shift;
+    line = 0;
+    for (b = 0; b < nb; b++) {
+        size_t off = (size_t)b << shift;
+        while (line + 1 < m->nlines && m->start[line + 1] <= off) line++;
+        m->bucket[b] = line;
+    }
+    m->dirty = 0;
+    return 1;
+}
+
+/* Line index holding pos (pos must be below m->end). */
+static inline unsigned sm_line_index(sm_map *m, sm_pos pos)
+{
+    unsigned b = pos >> m->shift;
+    unsigned lo = m->bucket[b], hi = m->bucket[b + 1], mid;
+
+    /* start[lo] <= pos; the answer is in [lo, hi] */
+    while (hi - lo > 4) {
+        mid = lo + (hi - lo + 1) / 2;
+        if (m->start[mid] <= pos) lo = mid;
+        else hi = mid - 1;
+    }
+    while (lo < hi && m->start[lo + 1] <= pos) lo++;
+    return lo;
+}
+
+static inline sm_loc sm_lookup(sm_map *m, sm_pos pos)
+{
+    sm_loc loc;
+    unsigned line;
+    int lo, hi, mid;
+
+    loc.file = NULL;
+    loc.line = loc.col = 0;
+    /* the end of the last file still has a column: "line 9, column 1" */
+    if (pos == SM_NONE || m->nfiles == 0 || pos > m->end) return loc;
+    if (m->sparse) {
+        /* the last line is still open; then the latest start at or below pos */
+        if (!sm_sparse_keep(m, m->end + 1)) return loc;
+        lo = 0;
+        hi = (int)m->nlines - 1;
+        while (lo < hi) {
+            mid = (lo + hi + 1) / 2;
+            if (m->start[mid] <= pos) lo = mid;
+            else hi = mid - 1;
+        }
+        if (hi < 0 || m->start[lo] > pos) return loc;
+        line = (unsigned)lo;
+    } else {
+        if (m->dirty && !sm_build_buckets(m)) return loc;
+        line = pos == m->end ? m->nlines - 1 : sm_line_index(m, pos);
+    }
+
+    lo = 0;
+    hi = m->nfiles - 1;
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if (m->file[mid].first <= line) lo = mid;
+        else hi = mid - 1;
+    }
+    loc.file = m->file[lo].name;
+    loc.line = m->sparse ? m->lineno[line] : line - m->file[lo].first + 1;
+    loc.col = pos - m->start[line] + 1;
+    return loc;
+}
+
+#endif /* SOURCE_MAP_H */
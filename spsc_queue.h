@@ -0,0 +1,66 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+/* spsc_queue.h
+    Bounded lock-free single-producer/single-consumer ring of pointers
+    Exactly one thread may push and exactly one thread may pop.  Head and
+    tail only ever grow; the slot is the counter modulo SPSC_CAP.  Each
+    side owns one counter and only reads the other one, so no locks or
+    read-modify-write atomics are needed.  A full ring makes the producer
+    wait, which is what bounds memory in a pipeline.
+*/
+#include "thread_compat.h"
+
+#define SPSC_CAP 64             /* power of two */
+#define SPSC_SPIN 256           /* busy polls before yielding the CPU */
+
+typedef struct {
+    volatile long head;         /* next slot to pop, written by the consumer */
+    char pad1[64 - sizeof(long)];
+    volatile long tail;         /* next slot to push, written by the producer */
+    char pad2[64 - sizeof(long)];
+    void *slot[SPSC_CAP];
+} spsc_queue;
+
+static inline void spsc_init(spsc_queue *q)
+{
+    q->head = 0;
+    q->tail = 0;
+}
+
+static inline int spsc_try_push(spsc_queue *q, void *item)
+{
+    unsigned long tail = (unsigned long)q->tail;
+    if (tail - (unsigned long)atomic_load_acq(&q->head) == SPSC_CAP) return 0;
+    q->slot[tail & (SPSC_CAP - 1)] = item;
+    atomic_store_rel(&q->tail, (long)(tail + 1));
+    return 1;
+}
+
+static inline void *spsc_try_pop(spsc_queue *q)
+{
+    unsigned long head = (unsigned long)q->head;
+    void *item;
+    if (head == (unsigned long)atomic_load_acq(&q->tail)) return NULL;
+    item = q->slot[head & (SPSC_CAP - 1)];
+    atomic_store_rel(&q->head, (long)(head + 1));
+    return item;
+}
+
+static inline void spsc_push(spsc_queue *q, void *item)
+{
+    int spins = 0;
+    while (!spsc_try_push(q, item))
+        if (++spins % SPSC_SPIN == 0) thread_yield();
+}
+
+/* item must not be NULL for the blocking pop to see it */
+static inline void *spsc_pop(spsc_queue *q)
+{
+    int spins = 0;
+    void *item;
+    while ((item = spsc_try_pop(q)) == NULL)
+        if (++spins % SPSC_SPIN == 0) thread_yield();
+    return item;
+}
+
+#endif /* SPSC_QUEUE_H */
@@ -0,0 +1,396 @@
+#ifndef TEXT_INPUT_H
+#define TEXT_INPUT_H
+/* text_input.h
+    Input layer of project_lexer.c: reads the source in large blocks,
+    works out its encoding from the BOM and hands out lines as UTF-8
+      - no BOM or a UTF-8 BOM: the bytes are validated where fread put
+        them and lines point straight into the read buffer
+      - UTF-16 LE or BE BOM (what PowerShell's > writes): transcoded to
+        UTF-8 a block at a time into the line buffer
+    Both kernels skip ASCII 64/16 bytes at a time with SSE2 (8 at a time
+    in 64-bit words on other targets); only non-ASCII characters take
+    the scalar path.  Invalid text is reported when the line holding it
+    is reached, so everything before it is lexed as usual.
+    ti_getline() cuts lines like fgets(line, max, f) does, so long lines
+    come back in the same pieces as before.
+    ti_open_mem() reads a file already in memory (batch mode, see
+    batch_io.h) the same way, without copying UTF-8 text; the bytes
+    ti_getline() cuts lines with are put back, so the text is as it was
+    once the reader reaches the end.
+    ti_offset() places a line in the decoded text, and ti_getblock()
+    hands that text out unsplit, so a second pass (the parser's source
+    map) sees the same offsets as the first.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memprof.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TI_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#define TI_BLOCK (64 * 1024)        /* bytes per fread */
+#define TI_MAXLINE 1024             /* longest line piece ti_getline hands out */
+
+enum { TI_UTF8, TI_UTF16LE, TI_UTF16BE };
+
+static const char *const ti_encoding_name[3] = { "UTF-8", "UTF-16 LE", "UTF-16 BE" };
+
+typedef struct {
+    FILE *f;
+    int enc;
+    char *buf;                      /* UTF-8 text; lines are handed out from here */
+    size_t cap;
+    size_t base;                    /* offset of buf[0] in the decoded text */
+    size_t start, end;              /* [start, end) not handed out yet */
+    size_t checked;                 /* text before this offset is known valid */
+    unsigned char *raw;             /* UTF-16: bytes read but not transcoded yet */
+    size_t raw_len;
+    int eof;                        /* fread has nothing more */
+    int borrowed;                   /* ti_open_mem: the caller's buffer is buf (UTF-8) or raw (UTF-16) */
+    int invalid;                    /* the text at buf[checked] is invalid */
+    int has_cut;                    /* buf[cut] was overwritten by a NUL */
+    size_t cut;
+    char cut_char;
+    const char *err;
+} ti_reader;
+
+/* Length of the leading run of ASCII bytes in s[0..n). */
+static inline size_t ti_ascii_run(const unsigned char *s, size_t n)
+{
+    size_t i = 0;
+#ifdef TI_SSE2
+    while (i + 64 <= n) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(s + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(s + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(s + i + 48));
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)))) break;
+        i += 64;
+    }
+    while (i + 16 <= n) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)))) break;
+        i += 16;
+    }
+#else
+    while (i + 8 <= n) {
+        unsigned long long w;
+        memcpy(&w, s + i, 8);
+        if (w & 0x8080808080808080ULL) break;
+        i += 8;
+    }
+#endif
+    while (i < n && s[i] < 0x80) i++;
+    return i;
+}
+
+/* Validates UTF-8 in s[0..n).  Returns how far the text is valid.  A
+   character cut off by the end of s stops the scan there and waits for
+   more input, unless at_eof.  *invalid is set when the scan stopped on
+   an invalid sequence (overlong forms, surrogates and code points past
+   U+10FFFF included). */
+static inline size_t ti_utf8_check(const unsigned char *s, size_t n, int at_eof, int *invalid)
+{
+    size_t i = 0, len, k;
+    unsigned char c, lo, hi;
+
+    *invalid = 0;
+    for (;;) {
+        i += ti_ascii_run(s + i, n - i);
+        if (i == n) return n;
+        c = s[i];
+        lo = 0x80;
+        hi = 0xBF;
+        if (c < 0xC2) {
+            *invalid = 1;
+            return i;
+        } else if (c < 0xE0) {
+            len = 2;
+        } else if (c < 0xF0) {
+            len = 3;
+            if (c == 0xE0) lo = 0xA0;
+            if (c == 0xED) hi = 0x9F;
+        } else if (c < 0xF5) {
+            len = 4;
+            if (c == 0xF0) lo = 0x90;
+            if (c == 0xF4) hi = 0x8F;
+        } else {
+            *invalid = 1;
+            return i;
+        }
+        for (k = 1; k < len; k++) {
+            if (i + k == n) {
+                if (at_eof) *invalid = 1;
+                return i;
+            }
+            if (s[i + k] < (k == 1 ? lo : 0x80) || s[i + k] > (k == 1 ? hi : 0xBF)) {
+                *invalid = 1;
+                return i;
+            }
+        }
+        i += len;
+    }
+}
+
+static inline size_t ti_put_utf8(char *dst, unsigned long cp)
+{
+    if (cp < 0x80) {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* Transcodes UTF-16 src[0..n) to UTF-8 in dst, which needs room for
+   3 * n / 2 bytes.  Returns the source bytes used and sets *out to the
+   bytes written.  An odd last byte or a high surrogate at the end of
+   src waits for more input unless at_eof; an unpaired surrogate stops
+   the conversion just before it with *invalid set. */
+static inline size_t ti_utf16_to_utf8(const unsigned char *src, size_t n, int big_endian, int at_eof,
+                                      char *dst, size_t *out, int *invalid)
+{
+    size_t i = 0, o = 0;
+    unsigned long u, u2;
+
+    *invalid = 0;
+    for (;;) {
+#ifdef TI_SSE2
+        /* 8 code units at a time while they are all ASCII */
+        while (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            if (big_endian) v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xFF80)),
+                                                  _mm_setzero_si128())) != 0xFFFF)
+                break;
+            _mm_storel_epi64((__m128i *)(dst + o), _mm_packus_epi16(v, v));
+            i += 16;
+            o += 8;
+        }
+#endif
+        if (i + 2 > n) break;
+        u = big_endian ? (unsigned long)src[i] << 8 | src[i + 1] : (unsigned long)src[i + 1] << 8 | src[i];
+        if (u >= 0xD800 && u <= 0xDFFF) {
+            if (u >= 0xDC00) {
+                *invalid = 1;
+                break;
+            }
+            if (i + 4 > n) {
+                if (at_eof) *invalid = 1;
+                break;
+            }
+            u2 = big_endian ? (unsigned long)src[i + 2] << 8 | src[i + 3] : (unsigned long)src[i + 3] << 8 | src[i + 2];
+            if (u2 < 0xDC00 || u2 > 0xDFFF) {
+                *invalid = 1;
+                break;
+            }
+            o += ti_put_utf8(dst + o, 0x10000 + ((u - 0xD800) << 10) + (u2 - 0xDC00));
+            i += 4;
+        } else {
+            o += ti_put_utf8(dst + o, u);
+            i += 2;
+        }
+    }
+    if (!*invalid && at_eof && i < n) *invalid = 1;   /* odd trailing byte */
+    *out = o;
+    return i;
+}
+
+/* Runs the encoding kernel over what the last fread brought in. */
+static inline void ti_decode(ti_reader *r)
+{
+    size_t used, out;
+    int bad;
+
+    if (r->invalid) return;
+    if (r->enc == TI_UTF8) {
+        r->checked += ti_utf8_check((const unsigned char *)r->buf + r->checked, r->end - r->checked, r->eof, &bad);
+    } else {
+        used = ti_utf16_to_utf8(r->raw, r->raw_len, r->enc == TI_UTF16BE, r->eof, r->buf + r->end, &out, &bad);
+        r->end += out;
+        r->checked = r->end;
+        memmove(r->raw, r->raw + used, r->raw_len - used);
+        r->raw_len -= used;
+    }
+    if (bad) {
+        r->invalid = 1;
+        r->err = r->enc == TI_UTF8 ? "invalid UTF-8" : "invalid UTF-16";
+    }
+}
+
+static inline void ti_fill(ti_reader *r)
+{
+    size_t n;
+
+    if (r->eof) return;
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->base += r->start;
+        r->end -= r->start;
+        r->checked -= r->start;
+        r->start = 0;
+    }
+    if (r->enc == TI_UTF8) {
+        n = fread(r->buf + r->end, 1, r->cap - r->end - 1, r->f);
+        r->end += n;
+    } else {
+        n = fread(r->raw + r->raw_len, 1, TI_BLOCK - r->raw_len, r->f);
+        r->raw_len += n;
+    }
+    if (n == 0) r->eof = 1;
+    ti_decode(r);
+}
+
+/* Returns 0 if the buffers could not be allocated. */
+static inline int ti_open(ti_reader *r, FILE *f)
+{
+    unsigned char *b;
+    size_t n;
+
+    memset(r, 0, sizeof(*r));
+    r->f = f;
+    /* a partial line, then a block of UTF-8 or a transcoded UTF-16 block */
+    r->cap = TI_MAXLINE + 2 * TI_BLOCK;
+    r->buf = (char *)mp_malloc(MP_LEXER, r->cap);
+    if (!r->buf) return 0;
+    n = fread(r->buf, 1, TI_BLOCK, f);
+    if (n == 0) r->eof = 1;
+    b = (unsigned char *)r->buf;
+    if (n >= 2 && ((b[0] == 0xFF && b[1] == 0xFE) || (b[0] == 0xFE && b[1] == 0xFF))) {
+        r->enc = b[0] == 0xFF ? TI_UTF16LE : TI_UTF16BE;
+        r->raw = (unsigned char *)mp_malloc(MP_LEXER, TI_BLOCK);
+        if (!r->raw) return 0;
+        memcpy(r->raw, b + 2, n - 2);
+        r->raw_len = n - 2;
+    } else {
+        r->end = n;
+        if (n >= 3 && b[0] == 0xEF && b[1] == 0xBB && b[2] == 0xBF) r->start = r->checked = 3;
+    }
+    ti_decode(r);
+    return 1;
+}
+
+/* Reads data[0..len), which must have one spare byte after it; UTF-8
+   lines are handed out from data itself.  Returns 0 if the UTF-16
+   output buffer could not be allocated. */
+static inline int ti_open_mem(ti_reader *r, char *data, size_t len)
+{
+    unsigned char *b = (unsigned char *)data;
+
+    memset(r, 0, sizeof(*r));
+    r->eof = 1;
+    r->borrowed = 1;
+    if (len >= 2 && ((b[0] == 0xFF && b[1] == 0xFE) || (b[0] == 0xFE && b[1] == 0xFF))) {
+        r->enc = b[0] == 0xFF ? TI_UTF16LE : TI_UTF16BE;
+        r->raw = b + 2;
+        r->raw_len = len - 2;
+        r->cap = r->raw_len / 2 * 3 + 16;
+        r->buf = (char *)mp_malloc(MP_LEXER, r->cap);
+        if (!r->buf) return 0;
+    } else {
+        r->buf = data;
+        r->cap = len + 1;
+        r->end = len;
+        if (len >= 3 && b[0] == 0xEF && b[1] == 0xBB && b[2] == 0xBF) r->start = r->checked = 3;
+    }
+    ti_decode(r);
+    return 1;
+}
+
+static inline void ti_close(ti_reader *r)
+{
+    if (!r->borrowed || r->enc != TI_UTF8) mp_free(r->buf);
+    if (!r->borrowed) mp_free(r->raw);
+    r->buf = NULL;
+    r->raw = NULL;
+}
+
+/* Next line without its '\n', NUL terminated, valid until the next
+   call.  Like fgets(line, max, f), a line longer than max - 1 bytes
+   comes back in pieces.  Returns NULL at the end of the input, or with
+   r->err set when the line holds invalid text. */
+static inline char *ti_getline(ti_reader *r, int max)
+{
+    size_t lim, len, avail;
+    char *line, *nl;
+
+    if (max > TI_MAXLINE) max = TI_MAXLINE;
+    lim = (size_t)(max - 1);
+    if (r->has_cut) {
+        r->buf[r->cut] = r->cut_char;
+        r->has_cut = 0;
+    }
+    for (;;) {
+        avail = r->end - r->start;
+        len = avail < lim ? avail : lim;
+        nl = (char *)memchr(r->buf + r->start, '\n', len);
+        if (nl) len = (size_t)(nl - (r->buf + r->start)) + 1;
+        if (r->start + len <= r->checked && (nl || len == lim || (r->eof && !r->invalid))) break;
+        /* this line runs into the invalid text */
+        if (r->invalid) return NULL;
+        if (r->eof) {
+            /* unreachable: at the end everything is checked or invalid */
+            r->invalid = 1;
+            r->err = "truncated input";
+            return NULL;
+        }
+        ti_fill(r);
+    }
+    if (len == 0) return NULL;
+    line = r->buf + r->start;
+    r->start += len;
+    /* the NUL goes over the '\n', or over the first byte of the rest of
+       a long line; either way the byte is put back on the next call */
+    r->cut = line[len - 1] == '\n' ? r->start - 1 : r->start;
+    r->cut_char = r->buf[r->cut];
+    r->buf[r->cut] = 0;
+    r->has_cut = 1;
+    return line;
+}
+
+/* Offset in the decoded text (a UTF-8 BOM included) of p, a line from
+   the last ti_getline or ti_getblock call. */
+static inline size_t ti_offset(const ti_reader *r, const char *p)
+{
+    return r->base + (size_t)(p - r->buf);
+}
+
+/* Next stretch of decoded text, as much as is buffered, for a pass that
+   does not need it in lines; valid until the next call.  Returns NULL
+   at the end of the input, or with r->err set at invalid text. */
+static inline const char *ti_getblock(ti_reader *r, size_t *len)
+{
+    const char *p;
+
+    if (r->has_cut) {
+        r->buf[r->cut] = r->cut_char;
+        r->has_cut = 0;
+    }
+    while (r->start == r->checked) {
+        if (r->invalid || r->eof) return NULL;
+        ti_fill(r);
+    }
+    p = r->buf + r->start;
+    *len = r->checked - r->start;
+    r->start = r->checked;
+    return p;
+}
+
+#endif /* TEXT_INPUT_H */
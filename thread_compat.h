@@ -0,0 +1,221 @@
+#ifndef THREAD_COMPAT_H
+#define THREAD_COMPAT_H
+/* thread_compat.h
+    Minimal threads, locks, atomics and a wall clock for MSVC (Win32) and
+    POSIX builds
+    Thread functions are declared as
+        static THREAD_RET THREAD_CALL worker(void *arg)
+    and return THREAD_RESULT.  POSIX builds link with -pthread.
+    A cond_t is waited on with its mutex_t held, as pthread_cond_wait.
+*/
+#ifdef _WIN32
+#include <windows.h>
+
+typedef HANDLE thread_t;
+#define THREAD_RET DWORD
+#define THREAD_CALL WINAPI
+#define THREAD_RESULT 0
+
+static inline int thread_start(thread_t *t, THREAD_RET (THREAD_CALL *fn)(void *), void *arg)
+{
+    *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+    return *t ? 0 : -1;
+}
+
+static inline void thread_join(thread_t t)
+{
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+
+static inline void thread_yield(void)
+{
+    SwitchToThread();
+}
+
+static inline void sleep_ms(int ms)
+{
+    Sleep((DWORD)ms);
+}
+
+typedef SRWLOCK mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+
+static inline void mutex_init(mutex_t *m)
+{
+    InitializeSRWLock(m);
+}
+
+static inline void mutex_free(mutex_t *m)
+{
+    (void)m;
+}
+
+static inline void mutex_lock(mutex_t *m)
+{
+    AcquireSRWLockExclusive(m);
+}
+
+static inline void mutex_unlock(mutex_t *m)
+{
+    ReleaseSRWLockExclusive(m);
+}
+
+static inline void cond_init(cond_t *c)
+{
+    InitializeConditionVariable(c);
+}
+
+static inline void cond_free(cond_t *c)
+{
+    (void)c;
+}
+
+static inline void cond_wait(cond_t *c, mutex_t *m)
+{
+    SleepConditionVariableSRW(c, m, INFINITE, 0);
+}
+
+static inline void cond_wake_all(cond_t *c)
+{
+    WakeAllConditionVariable(c);
+}
+
+static inline int cpu_count(void)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+}
+
+static inline long atomic_load_acq(volatile long *p)
+{
+    return InterlockedCompareExchange(p, 0, 0);
+}
+
+static inline void atomic_store_rel(volatile long *p, long v)
+{
+    InterlockedExchange(p, v);
+}
+
+static inline long atomic_add(volatile long *p, long v)
+{
+    return InterlockedExchangeAdd(p, v) + v;
+}
+
+static inline double wall_seconds(void)
+{
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+}
+
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef pthread_t thread_t;
+#define THREAD_RET void *
+#define THREAD_CALL
+#define THREAD_RESULT NULL
+
+static inline int thread_start(thread_t *t, THREAD_RET (THREAD_CALL *fn)(void *), void *arg)
+{
+    return pthread_create(t, NULL, fn, arg) == 0 ? 0 : -1;
+}
+
+static inline void thread_join(thread_t t)
+{
+    pthread_join(t, NULL);
+}
+
+static inline void thread_yield(void)
+{
+    sched_yield();
+}
+
+static inline void sleep_ms(int ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+
+static inline void mutex_init(mutex_t *m)
+{
+    pthread_mutex_init(m, NULL);
+}
+
+static inline void mutex_free(mutex_t *m)
+{
+    pthread_mutex_destroy(m);
+}
+
+static inline void mutex_lock(mutex_t *m)
+{
+    pthread_mutex_lock(m);
+}
+
+static inline void mutex_unlock(mutex_t *m)
+{
+    pthread_mutex_unlock(m);
+}
+
+static inline void cond_init(cond_t *c)
+{
+    pthread_cond_init(c, NULL);
+}
+
+static inline void cond_free(cond_t *c)
+{
+    pthread_cond_destroy(c);
+}
+
+static inline void cond_wait(cond_t *c, mutex_t *m)
+{
+    pthread_cond_wait(c, m);
+}
+
+static inline void cond_wake_all(cond_t *c)
+{
+    pthread_cond_broadcast(c);
+}
+
+static inline int cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+static inline long atomic_load_acq(volatile long *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_rel(volatile long *p, long v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline long atomic_add(volatile long *p, long v)
+{
+    return __atomic_add_fetch(p, v, __ATOMIC_ACQ_REL);
+}
+
+static inline double wall_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif
+
+#endif /* THREAD_COMPAT_H */
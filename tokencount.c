@@ -1,70 +1,200 @@
+/* tokencount.c
+   Token statistics for C and DSL sources
+   Usage: tokencount [-j threads] [--top N] [path ...]
+     path is a file, a directory (searched recursively) or - for stdin;
+     with no path, input.c is counted as before.
+   Files are read in large blocks and counted in parallel, one job per
+   file or per 8 MB range of a large file (see tokencount_core.h).
+*/
+#define _POSIX_C_SOURCE 200809L     /* fseeko under -std=c11 (tokencount_core.h) */
+#define _FILE_OFFSET_BITS 64        /* and 64-bit offsets for it */
 #include <stdio.h>
-#include <ctype.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
-int main() {
-    FILE *fp = fopen("input.c", "r");
-    if (!fp) {
-        printf("File not found!\n");
-        return 0;
-    }
+#include "tokencount_core.h"
 
-    int keywords = 0, identifiers = 0, numbers = 0;
-    int operators = 0, delimiters = 0;
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
 
-    char word[100];
-    char c;
+#define DEFAULT_TOP 20
 
-    char *keywordList[] = {"int", "float", "return", "while", "printf", "dec"};
-    
-    while ((c = fgetc(fp)) != EOF) {
+typedef struct {
+    tc_job *job;
+    int n, cap;
+} job_list;
 
-        if (isalpha(c) || c == '_') {
-            int i = 0;
-            word[i++] = c;
+typedef struct {
+    const char *name;
+    long long count;
+} ident_row;
 
-            while (isalnum(c = fgetc(fp)) || c=='_')
-                word[i++] = c;
+static void add_job(job_list *jl, const tc_job *j){
+    if(jl->n == jl->cap){
+        jl->cap = jl->cap ? jl->cap * 2 : 64;
+        jl->job = (tc_job *)realloc(jl->job, jl->cap * sizeof(tc_job));
+        if(!jl->job){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+    }
+    jl->job[jl->n++] = *j;
+}
 
-            word[i] = '\0';
+// 0 = missing, 1 = regular file, 2 = directory
+static int path_kind(const char *path, long long *size){
+#ifdef _WIN32
+    struct _stat64 st;
+    if(_stat64(path, &st) != 0) return 0;
+    *size = st.st_size;
+    if(st.st_mode & _S_IFDIR) return 2;
+    return (st.st_mode & _S_IFREG) ? 1 : 0;
+#else
+    struct stat st;
+    if(stat(path, &st) != 0) return 0;
+    *size = (long long)st.st_size;
+    if(S_ISDIR(st.st_mode)) return 2;
+    return S_ISREG(st.st_mode) ? 1 : 0;
+#endif
+}
 
-            int isKey = 0;
-            for (int k = 0; k < 6; k++) {
-                if (strcmp(word, keywordList[k]) == 0) {
-                    isKey = 1;
-                    break;
-                }
-            }
+static void add_path(job_list *jl, const char *path);
 
-            if (isKey)
-                keywords++;
-            else
-                identifiers++;
+static void add_file(job_list *jl, const char *path, long long size){
+    // the jobs keep the path, so it must outlive them
+    char *p = (char *)malloc(strlen(path) + 1);
+    if(!p){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+    strcpy(p, path);
+    tc_job j;
+    memset(&j, 0, sizeof(j));
+    j.path = p;
+    for(long long start = 0; ; start += TC_CHUNK){
+        j.start = start;
+        j.stop = start + TC_CHUNK < size ? start + TC_CHUNK : -1;
+        add_job(jl, &j);
+        if(j.stop < 0) break;
+    }
+}
 
-            ungetc(c, fp);
-        }
+static void add_dir(job_list *jl, const char *dir){
+    char path[4096];
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    snprintf(path, sizeof(path), "%s\\*", dir);
+    HANDLE h = FindFirstFileA(path, &fd);
+    if(h == INVALID_HANDLE_VALUE) return;
+    do {
+        if(fd.cFileName[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s\\%s", dir, fd.cFileName);
+        add_path(jl, path);
+    } while(FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    DIR *d = opendir(dir);
+    struct dirent *e;
+    if(!d) return;
+    while((e = readdir(d)) != NULL){
+        // skips ".", ".." and hidden entries such as .git
+        if(e->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        add_path(jl, path);
+    }
+    closedir(d);
+#endif
+}
 
-        else if (isdigit(c)) {
-            numbers++;
-            while (isdigit(c = fgetc(fp)));
-            ungetc(c, fp);
-        }
+static void add_path(job_list *jl, const char *path){
+    long long size = 0;
+    switch(path_kind(path, &size)){
+    case 1: add_file(jl, path, size); break;
+    case 2: add_dir(jl, path); break;
+    }
+}
+
+static int by_count(const void *a, const void *b){
+    const ident_row *x = (const ident_row *)a, *y = (const ident_row *)b;
+    if(x->count != y->count) return x->count < y->count ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+static void print_report(tc_counts *c, int top){
+    printf("Token Count:\n");
+    printf("Keywords   = %lld\n", tc_keyword_total(c));
+    printf("Identifiers= %lld\n", c->identifiers);
+    printf("Numbers    = %lld\n", c->numbers);
+    printf("Operators  = %lld\n", c->operators);
+    printf("Delimiters = %lld\n", c->delimiters);
 
-        else if (c == '+' || c == '-' || c == '*' || c == '/' || c == '=')
-            operators++;
+    printf("\nKeyword frequency:\n");
+    for(int k = 0; k < TC_NKEYWORDS; k++)
+        printf("  %-10s = %lld\n", tc_keywords[k], c->keyword[k]);
 
-        else if (c == ';' || c == ',' || c == '(' || c == ')'
-              || c == '{' || c == '}')
-            delimiters++;
+    ident_row *rows = (ident_row *)malloc((c->idents.used + 1) * sizeof(ident_row));
+    if(!rows){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+    int n = 0;
+    for(int i = 0; i < c->idents.cap; i++){
+        tc_entry *e = &c->idents.slot[i];
+        if(!e->len) continue;
+        rows[n].name = tc_name(&c->idents, e);
+        rows[n].count = e->count;
+        n++;
     }
+    qsort(rows, n, sizeof(ident_row), by_count);
+    printf("\nIdentifier frequency (top %d of %d distinct):\n", top < n ? top : n, n);
+    for(int i = 0; i < n && i < top; i++)
+        printf("  %-10s = %lld\n", rows[i].name, rows[i].count);
+    free(rows);
+}
 
-    printf("Token Count:\n");
-    printf("Keywords   = %d\n", keywords);
-    printf("Identifiers= %d\n", identifiers);
-    printf("Numbers    = %d\n", numbers);
-    printf("Operators  = %d\n", operators);
-    printf("Delimiters = %d\n", delimiters);
-
-    fclose(fp);
-    return 0;
+int main(int argc, char **argv){
+    job_list jl = { NULL, 0, 0 };
+    int threads = cpu_count(), top = DEFAULT_TOP, npaths = 0, used_stdin = 0;
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){ threads = atoi(argv[++i]); continue; }
+        if(strcmp(argv[i], "--top") == 0 && i + 1 < argc){ top = atoi(argv[++i]); continue; }
+        npaths++;
+        if(strcmp(argv[i], "-") == 0){
+            if(used_stdin) continue;
+            used_stdin = 1;
+#ifdef _WIN32
+            _setmode(_fileno(stdin), _O_BINARY);
+#endif
+            tc_job j;
+            memset(&j, 0, sizeof(j));
+            j.stream = stdin;
+            j.stop = -1;
+            add_job(&jl, &j);
+            continue;
+        }
+        long long size;
+        if(!path_kind(argv[i], &size)){
+            printf("File not found! (%s)\n", argv[i]);
+            continue;
+        }
+        add_path(&jl, argv[i]);
+    }
+    if(npaths == 0){
+        long long size;
+        if(path_kind("input.c", &size) != 1){
+            printf("File not found!\n");
+            return 0;
+        }
+        add_path(&jl, "input.c");
+    }
+
+    tc_counts total;
+    tc_counts_init(&total);
+    int failed = jl.n ? tc_run(jl.job, jl.n, threads, &total) : 0;
+    print_report(&total, top);
+
+    tc_table_free(&total.idents);
+    // the jobs of one file share its path; each path starts at offset 0
+    for(int i = 0; i < jl.n; i++)
+        if(jl.job[i].path && jl.job[i].start == 0) free((void *)jl.job[i].path);
+    free(jl.job);
+    return failed ? 1 : 0;
 }
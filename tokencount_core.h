@@ -0,0 +1,363 @@
+#ifndef TOKENCOUNT_CORE_H
+#define TOKENCOUNT_CORE_H
+/* tokencount_core.h
+   Streaming token statistics for tokencount.c and bench_tokencount.c
+
+   Categories are the ones tokencount has always reported: keywords,
+   identifiers, numbers, operators (+ - * / =) and delimiters
+   (; , ( ) { }), plus per-keyword and per-identifier histograms.
+
+   Input is split into jobs (a whole file, a byte range of a large file,
+   or a memory range) that worker threads count independently and merge.
+   A range [start, stop) owns every token that starts inside it; the one
+   word or number crossing stop is finished by the range it started in,
+   and skipped by the next range, so the totals match a single pass.
+
+   Ranges of large files are reached with fseeko, so a file that includes
+   this defines _POSIX_C_SOURCE 200809L and _FILE_OFFSET_BITS 64 before
+   its first #include, as tokencount.c does.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lexer_tables.h"
+#include "thread_compat.h"
+
+#ifdef _MSC_VER
+#define tc_fseek _fseeki64
+#else
+#define tc_fseek fseeko
+#endif
+
+#define TC_BLOCK (1 << 20)          /* bytes per read */
+#define TC_CHUNK (8LL << 20)        /* large files are split into ranges of this size */
+#define TC_NKEYWORDS 6
+
+static const char *const tc_keywords[TC_NKEYWORDS] = {"int", "float", "return", "while", "printf", "dec"};
+static const int tc_keyword_len[TC_NKEYWORDS] = {3, 5, 6, 5, 6, 3};
+
+#define TC_WORD(c) (lex_cclass[(unsigned char)(c)] & LEX_C_IDENT_CHAR)
+
+typedef struct {
+    size_t off;                     /* name offset in the owning table's arena */
+    int len;                        /* 0 marks a free slot */
+    unsigned hash;
+    long long count;
+} tc_entry;
+
+typedef struct {
+    tc_entry *slot;
+    int cap;                        /* power of two */
+    int used;
+    char *arena;
+    size_t arena_used, arena_cap;
+} tc_table;
+
+typedef struct {
+    long long keyword[TC_NKEYWORDS];
+    long long identifiers, numbers, operators, delimiters;
+    long long bytes;
+    tc_table idents;
+} tc_counts;
+
+enum { TC_NONE, TC_IN_WORD, TC_IN_NUM, TC_SKIP };
+
+typedef struct {
+    int state;
+    char *word;                     /* current word, grows as needed */
+    int wlen, wcap;
+} tc_scanner;
+
+typedef struct {
+    const char *path;               /* NULL for memory or stdin jobs */
+    FILE *stream;                   /* stdin job when set */
+    const char *mem;                /* memory job when set */
+    long long mem_len;
+    long long start, stop;          /* stop < 0 means "to end of input" */
+} tc_job;
+
+static inline unsigned tc_hash(const char *s, int n){
+    unsigned h = 2166136261u;
+    for(int i = 0; i < n; i++){ h ^= (unsigned char)s[i]; h *= 16777619u; }
+    return h;
+}
+
+static inline void tc_table_init(tc_table *t){
+    t->cap = 1024;
+    t->used = 0;
+    t->slot = (tc_entry *)calloc(t->cap, sizeof(tc_entry));
+    t->arena = NULL;
+    t->arena_used = t->arena_cap = 0;
+}
+
+static inline void tc_table_free(tc_table *t){
+    free(t->slot);
+    free(t->arena);
+    memset(t, 0, sizeof(*t));
+}
+
+static inline size_t tc_arena_copy(tc_table *t, const char *s, int n){
+    if(t->arena_used + n + 1 > t->arena_cap){
+        size_t ncap = t->arena_cap ? t->arena_cap * 2 : 64 * 1024;
+        while(ncap < t->arena_used + n + 1) ncap *= 2;
+        char *na = (char *)realloc(t->arena, ncap);
+        if(!na){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+        t->arena = na;
+        t->arena_cap = ncap;
+    }
+    size_t off = t->arena_used;
+    memcpy(t->arena + off, s, n);
+    t->arena[off + n] = 0;
+    t->arena_used += n + 1;
+    return off;
+}
+
+static inline const char *tc_name(const tc_table *t, const tc_entry *e){
+    return t->arena + e->off;
+}
+
+static inline void tc_table_grow(tc_table *t){
+    int ncap = t->cap * 2;
+    tc_entry *ns = (tc_entry *)calloc(ncap, sizeof(tc_entry));
+    if(!ns){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+    for(int i = 0; i < t->cap; i++){
+        if(!t->slot[i].len) continue;
+        int j = t->slot[i].hash & (ncap - 1);
+        while(ns[j].len) j = (j + 1) & (ncap - 1);
+        ns[j] = t->slot[i];
+    }
+    free(t->slot);
+    t->slot = ns;
+    t->cap = ncap;
+}
+
+static inline void tc_table_add(tc_table *t, const char *s, int n, unsigned h, long long count){
+    int i = h & (t->cap - 1);
+    while(t->slot[i].len){
+        if(t->slot[i].hash == h && t->slot[i].len == n && memcmp(t->arena + t->slot[i].off, s, n) == 0){
+            t->slot[i].count += count;
+            return;
+        }
+        i = (i + 1) & (t->cap - 1);
+    }
+    t->slot[i].off = tc_arena_copy(t, s, n);
+    t->slot[i].len = n;
+    t->slot[i].hash = h;
+    t->slot[i].count = count;
+    if(++t->used * 2 > t->cap) tc_table_grow(t);
+}
+
+static inline void tc_counts_init(tc_counts *c){
+    memset(c, 0, sizeof(*c));
+    tc_table_init(&c->idents);
+}
+
+static inline void tc_counts_merge(tc_counts *dst, tc_counts *src){
+    for(int k = 0; k < TC_NKEYWORDS; k++) dst->keyword[k] += src->keyword[k];
+    dst->identifiers += src->identifiers;
+    dst->numbers += src->numbers;
+    dst->operators += src->operators;
+    dst->delimiters += src->delimiters;
+    dst->bytes += src->bytes;
+    for(int i = 0; i < src->idents.cap; i++){
+        tc_entry *e = &src->idents.slot[i];
+        if(e->len) tc_table_add(&dst->idents, tc_name(&src->idents, e), e->len, e->hash, e->count);
+    }
+}
+
+static inline long long tc_keyword_total(const tc_counts *c){
+    long long n = 0;
+    for(int k = 0; k < TC_NKEYWORDS; k++) n += c->keyword[k];
+    return n;
+}
+
+static inline void tc_end_word(tc_scanner *sc, tc_counts *c){
+    for(int k = 0; k < TC_NKEYWORDS; k++){
+        if(tc_keyword_len[k] == sc->wlen && memcmp(tc_keywords[k], sc->word, sc->wlen) == 0){
+            c->keyword[k]++;
+            return;
+        }
+    }
+    c->identifiers++;
+    tc_table_add(&c->idents, sc->word, sc->wlen, tc_hash(sc->word, sc->wlen), 1);
+}
+
+static inline void tc_word_char(tc_scanner *sc, char ch){
+    if(sc->wlen == sc->wcap){
+        sc->wcap = sc->wcap ? sc->wcap * 2 : 256;
+        sc->word = (char *)realloc(sc->word, sc->wcap);
+        if(!sc->word){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+    }
+    sc->word[sc->wlen++] = ch;
+}
+
+/* Feeds buf[0..n), whose first byte is at absolute offset pos.  Returns 1
+   once the first byte at or after stop that does not continue a word or
+   number is reached (stop < 0: never).  That byte is left for the next
+   range. */
+static inline int tc_feed(tc_scanner *sc, tc_counts *c, const char *buf, size_t n, long long pos, long long stop){
+    // bytes past stop belong to the next range, even if we read on to finish a word
+    if(stop < 0 || pos + (long long)n <= stop) c->bytes += (long long)n;
+    else if(pos < stop) c->bytes += stop - pos;
+    for(size_t i = 0; i < n; i++){
+        unsigned char ch = (unsigned char)buf[i];
+        if(TC_WORD(ch)){
+            switch(sc->state){
+            case TC_SKIP:
+                break;
+            case TC_IN_WORD:
+                tc_word_char(sc, (char)ch);
+                break;
+            case TC_IN_NUM:
+                if(lex_cclass[ch] & LEX_C_DIGIT) break;
+                // a letter or '_' right after digits starts a new word; it is
+                // part of the run the next range skips, so it is ours even past stop
+                sc->wlen = 0;
+                tc_word_char(sc, (char)ch);
+                sc->state = TC_IN_WORD;
+                break;
+            default:
+                // a token starting at or after stop is the next range's
+                if(stop >= 0 && pos + (long long)i >= stop) return 1;
+                if(lex_cclass[ch] & LEX_C_DIGIT){
+                    c->numbers++;
+                    sc->state = TC_IN_NUM;
+                } else {
+                    sc->wlen = 0;
+                    tc_word_char(sc, (char)ch);
+                    sc->state = TC_IN_WORD;
+                }
+                break;
+            }
+            continue;
+        }
+        if(sc->state == TC_IN_WORD) tc_end_word(sc, c);
+        sc->state = TC_NONE;
+        if(stop >= 0 && pos + (long long)i >= stop) return 1;
+        switch(ch){
+        case '+': case '-': case '*': case '/': case '=':
+            c->operators++;
+            break;
+        case ';': case ',': case '(': case ')': case '{': case '}':
+            c->delimiters++;
+            break;
+        }
+    }
+    return 0;
+}
+
+static inline void tc_finish(tc_scanner *sc, tc_counts *c){
+    if(sc->state == TC_IN_WORD) tc_end_word(sc, c);
+    sc->state = TC_NONE;
+}
+
+/* Counts one job into c; returns 0 if the file could not be read. */
+static inline int tc_count_job(const tc_job *job, tc_counts *c, char *block){
+    tc_scanner sc = { TC_NONE, NULL, 0, 0 };
+    long long pos = job->start;
+    int done = 0, ok = 1;
+
+    if(job->mem){
+        if(job->start > 0 && TC_WORD(job->mem[job->start - 1])) sc.state = TC_SKIP;
+        tc_feed(&sc, c, job->mem + job->start, (size_t)(job->mem_len - job->start), pos, job->stop);
+        tc_finish(&sc, c);
+        free(sc.word);
+        return 1;
+    }
+
+    FILE *f = job->stream;
+    if(!f){
+        f = fopen(job->path, "rb");
+        if(!f) return 0;
+        if(job->start > 0){
+            // look at the byte before the range to see if a word crosses into it
+            if(tc_fseek(f, job->start - 1, SEEK_SET) != 0){ fclose(f); return 0; }
+            int prev = fgetc(f);
+            if(prev != EOF && TC_WORD(prev)) sc.state = TC_SKIP;
+        }
+    }
+    while(!done){
+        size_t n = fread(block, 1, TC_BLOCK, f);
+        if(n == 0){ if(ferror(f)) ok = 0; break; }
+        done = tc_feed(&sc, c, block, n, pos, job->stop);
+        pos += (long long)n;
+    }
+    tc_finish(&sc, c);
+    if(!job->stream) fclose(f);
+    free(sc.word);
+    return ok;
+}
+
+typedef struct {
+    const tc_job *jobs;
+    int njobs;
+    volatile long next;             /* next job to hand out */
+    volatile long failed;
+    tc_counts *partial;             /* one per worker */
+} tc_pool;
+
+typedef struct {
+    tc_pool *pool;
+    int id;
+} tc_worker_arg;
+
+static inline THREAD_RET THREAD_CALL tc_worker(void *arg){
+    tc_worker_arg *wa = (tc_worker_arg *)arg;
+    tc_pool *pool = wa->pool;
+    char *block = (char *)malloc(TC_BLOCK);
+    long j;
+    if(!block){ atomic_add(&pool->failed, 1); return THREAD_RESULT; }
+    while((j = atomic_add(&pool->next, 1) - 1) < pool->njobs){
+        if(!tc_count_job(&pool->jobs[j], &pool->partial[wa->id], block)){
+            fprintf(stderr, "tokencount: cannot read %s\n", pool->jobs[j].path ? pool->jobs[j].path : "<stdin>");
+            atomic_add(&pool->failed, 1);
+        }
+    }
+    free(block);
+    return THREAD_RESULT;
+}
+
+/* Runs all jobs on up to nthreads threads and merges into total.
+   Returns the number of jobs that failed. */
+static inline int tc_run(const tc_job *jobs, int njobs, int nthreads, tc_counts *total){
+    tc_pool pool;
+    thread_t *tid;
+    tc_worker_arg *args;
+    int started = 0;
+
+    if(nthreads > njobs) nthreads = njobs;
+    if(nthreads < 1) nthreads = 1;
+    pool.jobs = jobs;
+    pool.njobs = njobs;
+    pool.next = 0;
+    pool.failed = 0;
+    pool.partial = (tc_counts *)malloc(nthreads * sizeof(tc_counts));
+    tid = (thread_t *)malloc(nthreads * sizeof(thread_t));
+    args = (tc_worker_arg *)malloc(nthreads * sizeof(tc_worker_arg));
+    if(!pool.partial || !tid || !args){ fprintf(stderr, "tokencount: out of memory\n"); exit(1); }
+
+    for(int i = 0; i < nthreads; i++){
+        tc_counts_init(&pool.partial[i]);
+        args[i].pool = &pool;
+        args[i].id = i;
+    }
+    // the calling thread is worker 0
+    for(int i = 1; i < nthreads; i++){
+        if(thread_start(&tid[i], tc_worker, &args[i]) != 0) break;
+        started = i;
+    }
+    tc_worker(&args[0]);
+    for(int i = 1; i <= started; i++) thread_join(tid[i]);
+
+    for(int i = 0; i < nthreads; i++){
+        tc_counts_merge(total, &pool.partial[i]);
+        tc_table_free(&pool.partial[i].idents);
+    }
+    free(pool.partial);
+    free(tid);
+    free(args);
+    return (int)pool.failed;
+}
+
+#endif /* TOKENCOUNT_CORE_H */